@@ -0,0 +1,659 @@
+/**
+ * File              : ncwidgets_bench.c
+ * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
+ * Date              : 17.10.2026
+ * Last Modified Date: 17.10.2026
+ * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
+ */
+
+/*
+ * Benchmarks of ncwidgets on headless terminal.
+ * Usage: ncwidgets_bench [-q] [-s SCALE] [filter]
+ * -q       - quick run: sizes are divided by 10
+ * -s SCALE - divide sizes by SCALE
+ * filter   - run only benchmarks with filter in name
+ */
+
+#include "ncwidgets.h"
+#include "keys.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/* allocations counter - linked with -Wl,--wrap */
+static unsigned long allocs = 0;
+static unsigned long alloc_bytes = 0;
+
+#ifdef BENCH_COUNT_ALLOCS
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size){
+	allocs++;
+	alloc_bytes += size;
+	return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size){
+	allocs++;
+	alloc_bytes += n * size;
+	return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size){
+	allocs++;
+	alloc_bytes += size;
+	return __real_realloc(ptr, size);
+}
+#endif
+
+static int scale = 1;
+static const char *only = NULL;
+
+static bool selected(const char *name)
+{
+	return !only || strstr(name, only);
+}
+
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int compar(const void *a, const void *b)
+{
+	double x = *(double *)a, y = *(double *)b;
+	return x < y ? -1 : x > y;
+}
+
+/* benchmark runs step function iterations times and prints
+ * median and 99 percentile of step time, allocations and
+ * terminal output per step */
+struct bench {
+	const char *name;
+	int iterations;
+	int i;
+	double *times;
+	double start;
+	unsigned long allocs, alloc_bytes;
+	NcStats stats;
+};
+
+static bool bench_begin(struct bench *b, const char *name, int iterations)
+{
+	if (!selected(name))
+		return false;
+	b->name = name;
+	b->iterations = iterations > 0 ? iterations : 1;
+	b->i = 0;
+	b->times = malloc(b->iterations * sizeof(double));
+	b->allocs = allocs;
+	b->alloc_bytes = alloc_bytes;
+	nc_stats_get(&b->stats);
+	return true;
+}
+
+static void bench_start(struct bench *b)
+{
+	b->start = now();
+}
+
+static void bench_stop(struct bench *b)
+{
+	b->times[b->i++] = now() - b->start;
+}
+
+static void bench_end(struct bench *b)
+{
+	NcStats stats;
+	nc_stats_get(&stats);
+	qsort(b->times, b->i, sizeof(double), compar);
+	double median = b->times[b->i / 2];
+	double p99    = b->times[(b->i * 99) / 100];
+	printf(
+			"%-36s %8d %12.0f %12.0f %10.1f %12.0f %10.0f %8.1f\n",
+			b->name, b->i, median, p99,
+			(double)(allocs - b->allocs) / b->i,
+			(double)(alloc_bytes - b->alloc_bytes) / b->i,
+			(double)(stats.bytes - b->stats.bytes) / b->i,
+			(double)(stats.writes - b->stats.writes) / b->i);
+	free(b->times);
+}
+
+/* rows of list */
+static char **make_rows(int size)
+{
+	int i;
+	char **rows = malloc(size * sizeof(char *));
+	for (i = 0; i < size; ++i) {
+		char buf[128];
+		snprintf(buf, sizeof(buf),
+				"%07d </B>host-%03d<!B> status </%d>ok<!%d> 10.0.%d.%d",
+				i, i % 100, i % 64 + 1, i % 64 + 1, i / 256 % 256, i % 256);
+		rows[i] = strdup(buf);
+	}
+	return rows;
+}
+
+static void free_rows(char **rows, int size)
+{
+	int i;
+	for (i = 0; i < size; ++i)
+		free(rows[i]);
+	free(rows);
+}
+
+static void bench_line(void *userdata, NcText *line)
+{
+	(void)userdata;
+	nc_text_free(line);
+}
+
+static void bench_strings()
+{
+	struct bench b;
+	int i, n = 100000 / scale;
+	const char *ascii =
+		"The quick brown fox jumps over the lazy dog </B>bold<!B> 0123456789";
+	const char *utf8 =
+		"Съешь же ещё этих мягких французских булок, да выпей чаю </B>жирный<!B>";
+
+	if (bench_begin(&b, "str2ucharstr ascii", n)){
+		for (i = 0; i < n; ++i) {
+			bench_start(&b);
+			u8char_t *s = str2ucharstr(ascii, WHITE_ON_BLACK);
+			bench_stop(&b);
+			free(s);
+		}
+		bench_end(&b);
+	}
+
+	if (bench_begin(&b, "str2ucharstr multibyte", n)){
+		for (i = 0; i < n; ++i) {
+			bench_start(&b);
+			u8char_t *s = str2ucharstr(utf8, WHITE_ON_BLACK);
+			bench_stop(&b);
+			free(s);
+		}
+		bench_end(&b);
+	}
+
+	if (bench_begin(&b, "nc_text_new ascii", n)){
+		for (i = 0; i < n; ++i) {
+			bench_start(&b);
+			NcText *t = nc_text_new(ascii, WHITE_ON_BLACK);
+			bench_stop(&b);
+			nc_text_free(t);
+		}
+		bench_end(&b);
+	}
+
+	if (bench_begin(&b, "nc_text_new multibyte", n)){
+		for (i = 0; i < n; ++i) {
+			bench_start(&b);
+			NcText *t = nc_text_new(utf8, WHITE_ON_BLACK);
+			bench_stop(&b);
+			nc_text_free(t);
+		}
+		bench_end(&b);
+	}
+
+	NcTemplate *tpl = nc_template_new(
+			"</B>CPU<!B> %s%% </B>mem<!B> %s load %s", WHITE_ON_BLACK);
+	NcText *text = NULL;
+	if (bench_begin(&b, "nc_template_render", n)){
+		for (i = 0; i < n; ++i) {
+			char cpu[16];
+			snprintf(cpu, sizeof(cpu), "%d", i % 100);
+			const char *values[] = {cpu, "1.5G", "0.42"};
+			bench_start(&b);
+			text = nc_template_render(tpl, text, values);
+			bench_stop(&b);
+		}
+		bench_end(&b);
+	}
+	nc_text_free(text);
+	nc_template_free(tpl);
+
+	// colored output of compiler by chunks of pipe
+	const char *ansi =
+		"\033[01m\033[Ksrc/main.c:12:5:\033[m\033[K \033[01;31m\033[Kerror:"
+		"\033[m\033[K unknown type name '\033[01m\033[Kfoo\033[m\033[K'\n";
+	size_t ansilen = strlen(ansi);
+	NcDecoder *decoder = nc_decoder_new(WHITE_ON_BLACK, bench_line, NULL);
+	nc_decoder_set_ansi(decoder, true);
+	if (bench_begin(&b, "nc_decoder_feed ansi line", n)){
+		for (i = 0; i < n; ++i) {
+			bench_start(&b);
+			nc_decoder_feed(decoder, ansi, ansilen / 2);
+			nc_decoder_feed(decoder, &ansi[ansilen / 2], ansilen - ansilen / 2);
+			bench_stop(&b);
+		}
+		bench_end(&b);
+	}
+	nc_decoder_free(decoder);
+
+	u8char_t *a = str2ucharstr(ascii, WHITE_ON_BLACK);
+	u8char_t *u = str2ucharstr(utf8,  WHITE_ON_BLACK);
+	if (bench_begin(&b, "ucharstr2str ascii", n)){
+		for (i = 0; i < n; ++i) {
+			bench_start(&b);
+			char *s = ucharstr2str(a);
+			bench_stop(&b);
+			free(s);
+		}
+		bench_end(&b);
+	}
+
+	if (bench_begin(&b, "ucharstr2str multibyte", n)){
+		for (i = 0; i < n; ++i) {
+			bench_start(&b);
+			char *s = ucharstr2str(u);
+			bench_stop(&b);
+			free(s);
+		}
+		bench_end(&b);
+	}
+	free(a);
+	free(u);
+}
+
+static void bench_list(int size, bool borrowed,
+		const char *set_name, const char *refresh_name)
+{
+	struct bench b;
+	int i;
+	char **rows = make_rows(size);
+
+	NcWidget *list = nc_list_new(NULL, "list", LINES - 2, COLS - 4, 1, 2,
+			WHITE_ON_BLUE, rows, 1, true, true);
+	nc_widget_set_focused(list, true);
+	nc_frame_commit();
+
+	if (bench_begin(&b, set_name, 5)){
+		for (i = 0; i < 5; ++i) {
+			bench_start(&b);
+			if (borrowed)
+				nc_list_set_borrowed((NcList *)list, (const char **)rows, size);
+			else
+				nc_list_set_value((NcList *)list, rows, size);
+			nc_frame_commit();
+			bench_stop(&b);
+		}
+		bench_end(&b);
+	} else if (borrowed)
+		nc_list_set_borrowed((NcList *)list, (const char **)rows, size);
+	else
+		nc_list_set_value((NcList *)list, rows, size);
+
+	int n = 10000 / scale;
+	if (bench_begin(&b, refresh_name, n)){
+		for (i = 0; i < n; ++i) {
+			bench_start(&b);
+			nc_list_set_selected((NcList *)list,
+					(long)i * 7919 % size);
+			nc_frame_commit();
+			bench_stop(&b);
+		}
+		bench_end(&b);
+	}
+
+	nc_widget_destroy(list);
+	free_rows(rows, size);
+	nc_frame_commit();
+}
+
+static int bench_fill(void *userdata, int index, char *buf, size_t len)
+{
+	(void)userdata;
+	snprintf(buf, len,
+			"%07d </B>host-%03d<!B> status </%d>ok<!%d> 10.0.%d.%d",
+			index, index % 100, index % 64 + 1, index % 64 + 1,
+			index / 256 % 256, index % 256);
+	return 0;
+}
+
+static void bench_virtual(int size)
+{
+	struct bench b;
+	int i, n = 10000 / scale;
+
+	if (bench_begin(&b, "nc_list_new_virtual 10M", 5)){
+		for (i = 0; i < 5; ++i) {
+			bench_start(&b);
+			NcWidget *list = nc_list_new_virtual(NULL, "list",
+					LINES - 2, COLS - 4, 1, 2, WHITE_ON_BLUE,
+					size, bench_fill, NULL, true, true);
+			nc_frame_commit();
+			bench_stop(&b);
+			nc_widget_destroy(list);
+			nc_frame_commit();
+		}
+		bench_end(&b);
+	}
+
+	NcWidget *list = nc_list_new_virtual(NULL, "list",
+			LINES - 2, COLS - 4, 1, 2, WHITE_ON_BLUE,
+			size, bench_fill, NULL, true, true);
+	nc_widget_set_focused(list, true);
+	nc_frame_commit();
+	if (bench_begin(&b, "nc_list_refresh virtual 10M", n)){
+		for (i = 0; i < n; ++i) {
+			bench_start(&b);
+			nc_list_set_selected((NcList *)list,
+					(long)i * 7919 % size);
+			nc_frame_commit();
+			bench_stop(&b);
+		}
+		bench_end(&b);
+	}
+
+	// scroll over rows decoded before - rows come from cache
+	for (i = 0; i < 1000; ++i) {
+		nc_list_set_selected((NcList *)list, i);
+		nc_frame_commit();
+	}
+	if (bench_begin(&b, "nc_list_refresh virtual cached", n)){
+		for (i = 0; i < n; ++i) {
+			bench_start(&b);
+			nc_list_set_selected((NcList *)list,
+					(long)i * 7919 % 1000);
+			nc_frame_commit();
+			bench_stop(&b);
+		}
+		bench_end(&b);
+	}
+	nc_widget_destroy(list);
+	nc_frame_commit();
+
+	// rows are fetched on worker, paint does not wait for them
+	list = nc_list_new_async(NULL, "list",
+			LINES - 2, COLS - 4, 1, 2, WHITE_ON_BLUE,
+			size, bench_fill, NULL, true, true);
+	nc_widget_set_focused(list, true);
+	nc_frame_commit();
+	if (bench_begin(&b, "nc_list_refresh async 10M", n)){
+		for (i = 0; i < n; ++i) {
+			bench_start(&b);
+			nc_list_set_selected((NcList *)list,
+					(long)i * 7919 % size);
+			nc_frame_update();
+			nc_frame_commit();
+			bench_stop(&b);
+		}
+		bench_end(&b);
+	}
+	nc_widget_destroy(list);
+	nc_frame_commit();
+}
+
+/* typing and erasing query of filter, one step per key */
+static void bench_filter(int size)
+{
+	struct bench b;
+	int i, k;
+	const char *query = "host-0421";
+	int len = strlen(query);
+
+	if (!selected("nc_list_set_filtering 500k") &&
+			!selected("nc_list_set_filter 500k") &&
+			!selected("nc_list_set_filter fuzzy 500k"))
+		return;
+
+	char **rows = make_rows(size);
+	NcWidget *list = nc_list_new(NULL, "list", LINES - 2, COLS - 4, 1, 2,
+			WHITE_ON_BLUE, NULL, 0, true, true);
+	nc_list_set_borrowed((NcList *)list, (const char **)rows, size);
+	nc_frame_commit();
+
+	if (bench_begin(&b, "nc_list_set_filtering 500k", 1)){
+		bench_start(&b);
+		nc_list_set_filtering((NcList *)list, true);
+		bench_stop(&b);
+		bench_end(&b);
+	} else
+		nc_list_set_filtering((NcList *)list, true);
+
+	int n = 100 / scale > 0 ? 100 / scale : 1;
+	if (bench_begin(&b, "nc_list_set_filter 500k", n * len * 2)){
+		char buf[64];
+		for (i = 0; i < n; ++i) {
+			for (k = 1; k <= len * 2; ++k) {
+				int l = k <= len ? k : len * 2 - k;
+				memcpy(buf, query, l);
+				buf[l] = 0;
+				bench_start(&b);
+				nc_list_set_filter((NcList *)list, buf);
+				nc_frame_commit();
+				bench_stop(&b);
+			}
+		}
+		bench_end(&b);
+	}
+
+	// ranked rows with marked chars
+	nc_list_set_fuzzy((NcList *)list, 1000, A_UNDERLINE);
+	if (bench_begin(&b, "nc_list_set_filter fuzzy 500k", n * len * 2)){
+		char buf[64];
+		for (i = 0; i < n; ++i) {
+			for (k = 1; k <= len * 2; ++k) {
+				int l = k <= len ? k : len * 2 - k;
+				memcpy(buf, query, l);
+				buf[l] = 0;
+				bench_start(&b);
+				nc_list_set_filter((NcList *)list, buf);
+				nc_frame_commit();
+				bench_stop(&b);
+			}
+		}
+		bench_end(&b);
+	}
+
+	nc_widget_destroy(list);
+	free_rows(rows, size);
+	nc_frame_commit();
+}
+
+static void bench_entry()
+{
+	struct bench b;
+	int i, k, chunk = 100, n = 100000 / scale;
+
+	NcWidget *entry = nc_entry_new(NULL, "entry", LINES - 2, COLS - 4, 1, 2,
+			WHITE_ON_BLUE, NULL, true, true, true);
+	nc_frame_commit();
+
+	if (bench_begin(&b, "NcEntry type x100", n / chunk)){
+		for (i = 0; i < n / chunk; ++i) {
+			for (k = 0; k < chunk; ++k)
+				nc_headless_feed_key(k % 10 == 9 ? ' ' : 'a' + k % 26);
+			nc_headless_feed_key(CTRL('x'));
+			bench_start(&b);
+			nc_widget_activate(entry, NULL, NULL);
+			bench_stop(&b);
+		}
+		bench_end(&b);
+	}
+
+	if (bench_begin(&b, "NcEntry delete x100", n / chunk)){
+		for (i = 0; i < n / chunk; ++i) {
+			for (k = 0; k < chunk; ++k)
+				nc_headless_feed_key(KEY_BACKSPACE);
+			nc_headless_feed_key(CTRL('x'));
+			bench_start(&b);
+			nc_widget_activate(entry, NULL, NULL);
+			bench_stop(&b);
+		}
+		bench_end(&b);
+	}
+
+	// export of large multiline value
+	size_t size = 64 * 1024;
+	char *value = malloc(size + 1);
+	for (k = 0; k < (int)size; ++k)
+		value[k] = k % 80 == 79 ? '\n' : 'a' + k % 26;
+	value[size] = 0;
+	nc_entry_set_value((NcEntry *)entry, value);
+
+	if (bench_begin(&b, "NcEntry get value 64k", n / chunk)){
+		for (i = 0; i < n / chunk; ++i) {
+			bench_start(&b);
+			char *s = nc_entry_get_value((NcEntry *)entry);
+			bench_stop(&b);
+			free(s);
+		}
+		bench_end(&b);
+	}
+
+	if (bench_begin(&b, "NcEntry copy value 64k", n / chunk)){
+		for (i = 0; i < n / chunk; ++i) {
+			bench_start(&b);
+			nc_entry_copy_value((NcEntry *)entry, value, size + 1);
+			bench_stop(&b);
+		}
+		bench_end(&b);
+	}
+	free(value);
+
+	nc_widget_destroy(entry);
+	nc_frame_commit();
+}
+
+static void bench_fselect()
+{
+	struct bench b;
+	int i, n = 100000 / scale;
+
+	if (!selected("NcFselect open 100k") && 
+			!selected("NcFselect page down"))
+		return;
+
+	char path[] = "/tmp/ncwidgets_benchXXXXXX";
+	if (!mkdtemp(path))
+		return;
+	for (i = 0; i < n; ++i) {
+		char file[BUFSIZ];
+		snprintf(file, BUFSIZ, "%s/file%06d.txt", path, i);
+		close(open(file, O_CREAT | O_WRONLY, 0644));
+	}
+
+	NcWidget *fselect = NULL;
+	if (bench_begin(&b, "NcFselect open 100k", 3)){
+		for (i = 0; i < 3; ++i) {
+			bench_start(&b);
+			fselect = nc_fselect_new(NULL, LINES - 2, COLS - 4, 1, 2,
+					WHITE_ON_BLUE, path, 0, A_BOLD, A_UNDERLINE, 0,
+					true, true);
+			nc_frame_commit();
+			bench_stop(&b);
+			if (i < 2)
+				nc_widget_destroy(fselect);
+		}
+		bench_end(&b);
+	}
+
+	// page down only
+	if (!fselect)
+		fselect = nc_fselect_new(NULL, LINES - 2, COLS - 4, 1, 2,
+				WHITE_ON_BLUE, path, 0, A_BOLD, A_UNDERLINE, 0,
+				true, true);
+
+	if (fselect && bench_begin(&b, "NcFselect page down", 100)){
+		for (i = 0; i < 100; ++i) {
+			nc_headless_feed_key(KEY_NPAGE);
+			nc_headless_feed_key(CTRL('x'));
+			bench_start(&b);
+			nc_widget_activate(fselect, NULL, NULL);
+			bench_stop(&b);
+		}
+		bench_end(&b);
+	}
+	if (fselect)
+		nc_widget_destroy(fselect);
+	nc_frame_commit();
+
+	for (i = 0; i < n; ++i) {
+		char file[BUFSIZ];
+		snprintf(file, BUFSIZ, "%s/file%06d.txt", path, i);
+		unlink(file);
+	}
+	rmdir(path);
+}
+
+static void bench_calendar()
+{
+	struct bench b;
+	int i, n = 10000 / scale;
+	time_t t = time(NULL);
+
+	NcWidget *calendar = nc_calendar_new(NULL, "calendar", 2, 2,
+			WHITE_ON_BLUE, t, 1, true, true);
+	nc_widget_set_focused(calendar, true);
+	nc_frame_commit();
+
+	if (bench_begin(&b, "NcCalendar month step", n)){
+		struct tm tm = *localtime(&t);
+		for (i = 0; i < n; ++i) {
+			tm.tm_mon++;
+			time_t next = mktime(&tm);
+			bench_start(&b);
+			nc_calendar_set((NcCalendar *)calendar, next);
+			nc_frame_commit();
+			bench_stop(&b);
+		}
+		bench_end(&b);
+	}
+
+	nc_widget_destroy(calendar);
+	nc_frame_commit();
+}
+
+int main(int argc, char *argv[])
+{
+	int i;
+	for (i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-q"))
+			scale = 10;
+		else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+			scale = atoi(argv[++i]);
+		else
+			only = argv[i];
+	}
+	if (scale < 1)
+		scale = 1;
+	setvbuf(stdout, NULL, _IOLBF, 0);
+
+	if (nc_init_headless("C.UTF-8", WHITE_ON_BLACK,
+				"xterm-256color", 50, 160, NULL))
+	{
+		fprintf(stderr, "can't init headless terminal\n");
+		return 1;
+	}
+
+	printf("%-36s %8s %12s %12s %10s %12s %10s %8s\n",
+			"benchmark", "iters", "median ns", "p99 ns",
+			"allocs", "alloc bytes", "out bytes", "writes");
+
+	bench_strings();
+	bench_list(10000 / scale, false, "nc_list_set_value 10k",
+			"nc_list_refresh 10k");
+	bench_list(1000000 / scale, false, "nc_list_set_value 1M",
+			"nc_list_refresh 1M");
+	bench_list(1000000 / scale, true, "nc_list_set_borrowed 1M",
+			"nc_list_refresh borrowed 1M");
+	bench_virtual(10000000);
+	bench_filter(500000 / scale);
+	bench_entry();
+	bench_fselect();
+	bench_calendar();
+
+	nc_quit();
+	return 0;
+}
@@ -2,7 +2,7 @@
  * File              : dialog.c
  * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
  * Date              : 08.05.2024
- * Last Modified Date: 10.05.2024
+ * Last Modified Date: 17.10.2026
  * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
  */
 
@@ -42,9 +42,9 @@ int nc_dialog(
 
 	// count cols
 	for (i = 0; i < count; ++i) {
-		u8char_t *info = str2ucharstr(buttons[i], color);
-		int len = ucharstrlen(info);
-		free(info);
+		NcText *info = nc_text_new(buttons[i], color);
+		int len = info ? nc_text_cols(info) : 0;
+		nc_text_free(info);
 		alen[i] = len;
 		cols += len;
 	}
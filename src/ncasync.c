@@ -0,0 +1,249 @@
+/**
+ * File              : ncasync.c
+ * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
+ * Date              : 17.10.2026
+ * Last Modified Date: 17.10.2026
+ * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
+ */
+
+#include "ncwidgets.h"
+#include "struct.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* rows of async list are fetched by pages on worker thread,
+ * list paints placeholder for rows which are not fetched
+ * and is repainted by nc_getch() when page arrives. Pages
+ * ahead of scroll direction are fetched before they are
+ * visible */
+
+// async lists - used only by main thread
+static NcListAsync *sources = NULL;
+
+static void *_nc_list_async_worker(void *arg)
+{
+	NcListAsync *a = arg;
+	int color = a->nclist->ncwidget.ncwin.color;
+	NcText *rows[NC_LIST_PAGE];
+	char buf[BUFSIZ];
+	int i;
+
+	pthread_mutex_lock(&a->lock);
+	while (!a->stop) {
+		// visible pages first, then last requested
+		NcListPage *page = NULL;
+		for (i = 0; i < NC_LIST_PAGES; ++i) {
+			NcListPage *p = &a->pages[i];
+			if (p->first < 0 || p->state != NcPageQueued)
+				continue;
+			if (!page || p->urgent > page->urgent ||
+					(p->urgent == page->urgent && p->used > page->used))
+				page = p;
+		}
+		if (!page){
+			pthread_cond_wait(&a->cond, &a->lock);
+			continue;
+		}
+
+		// loading page is not dropped by main thread
+		page->state = NcPageLoading;
+		int first = page->first;
+		int count = a->size - first < NC_LIST_PAGE ?
+			a->size - first : NC_LIST_PAGE;
+		pthread_mutex_unlock(&a->lock);
+
+		for (i = 0; i < count; ++i) {
+			rows[i] = NULL;
+			if (!a->fill(a->userdata, first + i, buf, sizeof(buf))){
+				buf[sizeof(buf) - 1] = 0;
+				rows[i] = _nc_text_row(buf, color);
+			}
+		}
+
+		pthread_mutex_lock(&a->lock);
+		for (i = 0; i < NC_LIST_PAGE; ++i)
+			page->rows[i] = i < count ? rows[i] : NULL;
+		page->state  = NcPageReady;
+		page->urgent = false;
+		a->arrived = true;
+	}
+	pthread_mutex_unlock(&a->lock);
+	return NULL;
+}
+
+static void _nc_list_page_drop(NcListPage *page)
+{
+	int i;
+	for (i = 0; i < NC_LIST_PAGE; ++i) {
+		nc_text_free(page->rows[i]);
+		page->rows[i] = NULL;
+	}
+	page->first = -1;
+}
+
+/* find page or queue it in place of oldest page, lock of
+ * async should be held */
+static NcListPage *_nc_list_page_request(
+		NcListAsync *a, int first, bool urgent)
+{
+	NcListPage *old = NULL;
+	int i;
+	for (i = 0; i < NC_LIST_PAGES; ++i) {
+		NcListPage *p = &a->pages[i];
+		if (p->first == first){
+			// urgency orders only pages which are not fetched
+			if (urgent && p->state != NcPageReady)
+				p->urgent = true;
+			p->used = ++a->clock;
+			return p;
+		}
+		if (p->state == NcPageLoading)
+			continue;
+		if (!old || p->first < 0 ||
+				(old->first >= 0 && p->used < old->used))
+			old = p;
+	}
+
+	_nc_list_page_drop(old);
+	old->first  = first;
+	old->state  = NcPageQueued;
+	old->urgent = urgent;
+	old->used   = ++a->clock;
+	pthread_cond_signal(&a->cond);
+	return old;
+}
+
+NcText *_nc_list_async_row(NcList *nclist, int index)
+{
+	NcListAsync *a = nclist->async;
+	if (nclist->ypos != a->last_ypos){
+		a->direction = nclist->ypos > a->last_ypos ? 1 : -1;
+		a->last_ypos = nclist->ypos;
+	}
+
+	int first = index / NC_LIST_PAGE * NC_LIST_PAGE, i;
+	pthread_mutex_lock(&a->lock);
+	NcListPage *page = _nc_list_page_request(a, first, true);
+	NcText *text = page->state == NcPageReady ?
+		page->rows[index - first] : a->placeholder;
+
+	for (i = 1; i <= NC_LIST_PREFETCH; ++i) {
+		int next = first + i * a->direction * NC_LIST_PAGE;
+		if (next >= 0 && next < a->size)
+			_nc_list_page_request(a, next, false);
+	}
+	pthread_mutex_unlock(&a->lock);
+
+	// pages are dropped only by main thread
+	return text;
+}
+
+bool _nc_list_async_poll()
+{
+	bool busy = false;
+	NcListAsync *a;
+	int i;
+	for (a = sources; a; a = a->next) {
+		pthread_mutex_lock(&a->lock);
+		bool arrived = a->arrived;
+		a->arrived = false;
+		for (i = 0; i < NC_LIST_PAGES; ++i)
+			if (a->pages[i].first >= 0 && a->pages[i].state != NcPageReady)
+				busy = true;
+		pthread_mutex_unlock(&a->lock);
+
+		if (arrived){
+			_nc_list_mark_all(a->nclist);
+			nc_widget_invalidate((NcWidget*)a->nclist);
+		}
+	}
+	return busy;
+}
+
+void _nc_list_async_free(NcList *nclist)
+{
+	NcListAsync *a = nclist->async, **p;
+	if (!a)
+		return;
+
+	pthread_mutex_lock(&a->lock);
+	a->stop = true;
+	pthread_cond_signal(&a->cond);
+	pthread_mutex_unlock(&a->lock);
+	pthread_join(a->thread, NULL);
+
+	int i;
+	for (i = 0; i < NC_LIST_PAGES; ++i)
+		_nc_list_page_drop(&a->pages[i]);
+	nc_text_free(a->placeholder);
+	pthread_mutex_destroy(&a->lock);
+	pthread_cond_destroy(&a->cond);
+
+	for (p = &sources; *p != a; p = &(*p)->next);
+	*p = a->next;
+	free(a);
+	nclist->async = NULL;
+}
+
+int nc_list_set_async(
+		NcList *nclist, int size, NcListFill fill, void *userdata)
+{
+	_nc_list_clear(nclist);
+
+	NcListAsync *a = calloc(1, sizeof(NcListAsync));
+	if (!a)
+		return -1;
+	a->nclist    = nclist;
+	a->fill      = fill;
+	a->userdata  = userdata;
+	a->size      = size;
+	a->direction = 1;
+	a->placeholder = nc_text_new("…", nclist->ncwidget.ncwin.color);
+	int i;
+	for (i = 0; i < NC_LIST_PAGES; ++i)
+		a->pages[i].first = -1;
+	pthread_mutex_init(&a->lock, NULL);
+	pthread_cond_init(&a->cond, NULL);
+	if (!a->placeholder ||
+			pthread_create(&a->thread, NULL, _nc_list_async_worker, a))
+	{
+		nc_text_free(a->placeholder);
+		pthread_mutex_destroy(&a->lock);
+		pthread_cond_destroy(&a->cond);
+		free(a);
+		return -1;
+	}
+
+	a->next = sources;
+	sources = a;
+	nclist->async = a;
+	nclist->size  = size;
+
+	_nc_list_mark_all(nclist);
+	nc_widget_invalidate((NcWidget*)nclist);
+	return 0;
+}
+
+NcWidget * nc_list_new_async(
+		NcWin *parent,
+		const char *title,
+		int h, int w, int y, int x,
+		int color,
+		int size,
+		NcListFill fill,
+		void *userdata,
+		bool box,
+		bool shadow
+		)
+{
+	NcList *nclist = (NcList *)_nc_list_new(parent, title, h, w, y, x,
+			color, NULL, 0, box, shadow, sizeof(NcList));
+	if (!nclist)
+		return NULL;
+	if (nc_list_set_async(nclist, size, fill, userdata)){
+		nc_widget_destroy((NcWidget *)nclist);
+		return NULL;
+	}
+	return (NcWidget*)nclist;
+}
@@ -2,7 +2,7 @@
  * File              : ncbutton.c
  * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
  * Date              : 14.06.2023
- * Last Modified Date: 09.05.2024
+ * Last Modified Date: 17.10.2026
  * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
  */
 
@@ -21,7 +21,7 @@ void nc_button_activate(
 
 	chtype ch;
 	while (ch != CTRL('x')) {
-		ch = getch();
+		ch = nc_getch();
 		// stop execution if callback not NULL
 		if (callback){
 			NCRET ret = callback(ncwidget, userdata, ch);
@@ -0,0 +1,239 @@
+/**
+ * File              : nccache.c
+ * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
+ * Date              : 17.10.2026
+ * Last Modified Date: 17.10.2026
+ * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
+ */
+
+#include "ncwidgets.h"
+#include "struct.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/* decoded rows of all widgets which can decode them again
+ * from source. Rows are kept in LRU order and dropped from
+ * the oldest when cache grows over budget, rows used in
+ * current frame are not dropped */
+
+#define NC_CACHE_BUDGET (4 * 1024 * 1024)
+
+typedef struct NcCacheRow {
+	const void *owner;
+	int index;
+	NcText *text;
+	size_t bytes;
+	unsigned long frame;         // frame of last use
+	struct NcCacheRow *prev;     // LRU list, head is newest
+	struct NcCacheRow *next;
+	struct NcCacheRow *chain;    // next row in bucket
+} NcCacheRow;
+
+static struct {
+	NcCacheRow **buckets;
+	size_t size;                 // power of 2
+	NcCacheRow *head, *tail;
+	unsigned long frame;
+	NcCacheStats stats;
+	pthread_mutex_t lock;
+} cache = {
+	NULL, 0, NULL, NULL, 0,
+	{0, 0, 0, 0, 0, NC_CACHE_BUDGET},
+	PTHREAD_MUTEX_INITIALIZER
+};
+
+static size_t _nc_cache_hash(const void *owner, int index)
+{
+	return (((uintptr_t)owner >> 4) * 2654435761u) ^
+		((unsigned int)index * 2246822519u);
+}
+
+static NcCacheRow **_nc_cache_find(const void *owner, int index)
+{
+	if (!cache.size)
+		return NULL;
+	NcCacheRow **p = &cache.buckets[
+		_nc_cache_hash(owner, index) & (cache.size - 1)];
+	while (*p && ((*p)->owner != owner || (*p)->index != index))
+		p = &(*p)->chain;
+	return p;
+}
+
+static void _nc_cache_unlink(NcCacheRow *row)
+{
+	if (row->prev)
+		row->prev->next = row->next;
+	else
+		cache.head = row->next;
+	if (row->next)
+		row->next->prev = row->prev;
+	else
+		cache.tail = row->prev;
+}
+
+static void _nc_cache_push(NcCacheRow *row)
+{
+	row->prev = NULL;
+	row->next = cache.head;
+	if (cache.head)
+		cache.head->prev = row;
+	cache.head = row;
+	if (!cache.tail)
+		cache.tail = row;
+}
+
+/* unlink row from table and LRU, row is freed by caller
+ * without lock */
+static NcCacheRow *_nc_cache_remove(NcCacheRow *row)
+{
+	NcCacheRow **p = _nc_cache_find(row->owner, row->index);
+	*p = row->chain;
+	_nc_cache_unlink(row);
+	cache.stats.rows--;
+	cache.stats.bytes -= row->bytes;
+	return row;
+}
+
+static int _nc_cache_grow()
+{
+	size_t size = cache.size ? cache.size * 2 : 1024, i;
+	NcCacheRow **buckets = calloc(size, sizeof(NcCacheRow *));
+	if (!buckets)
+		return -1;
+	for (i = 0; i < cache.size; ++i) {
+		NcCacheRow *row = cache.buckets[i];
+		while (row) {
+			NcCacheRow *chain = row->chain;
+			size_t k = _nc_cache_hash(row->owner, row->index) & (size - 1);
+			row->chain = buckets[k];
+			buckets[k] = row;
+			row = chain;
+		}
+	}
+	free(cache.buckets);
+	cache.buckets = buckets;
+	cache.size = size;
+	return 0;
+}
+
+NcText *_nc_cache_get(const void *owner, int index)
+{
+	pthread_mutex_lock(&cache.lock);
+	NcCacheRow **p = _nc_cache_find(owner, index);
+	NcText *text = NULL;
+	if (p && *p){
+		NcCacheRow *row = *p;
+		_nc_cache_unlink(row);
+		_nc_cache_push(row);
+		row->frame = cache.frame;
+		text = row->text;
+		cache.stats.hits++;
+	} else
+		cache.stats.misses++;
+	pthread_mutex_unlock(&cache.lock);
+	return text;
+}
+
+/* unlink oldest rows over budget, return them chained to
+ * be freed without lock */
+static NcCacheRow *_nc_cache_evict()
+{
+	NcCacheRow *evicted = NULL;
+	while (cache.stats.bytes > cache.stats.budget &&
+			cache.tail && cache.tail->frame != cache.frame)
+	{
+		NcCacheRow *row = _nc_cache_remove(cache.tail);
+		row->chain = evicted;
+		evicted = row;
+		cache.stats.evictions++;
+	}
+	return evicted;
+}
+
+static void _nc_cache_free(NcCacheRow *rows)
+{
+	while (rows) {
+		NcCacheRow *chain = rows->chain;
+		nc_text_free(rows->text);
+		free(rows);
+		rows = chain;
+	}
+}
+
+int _nc_cache_put(const void *owner, int index, NcText *text)
+{
+	NcCacheRow *row = malloc(sizeof(NcCacheRow));
+	if (!row)
+		return -1;
+	row->owner = owner;
+	row->index = index;
+	row->text  = text;
+	row->bytes = sizeof(NcCacheRow) + sizeof(NcText) +
+		text->nspans * sizeof(NcSpan) + text->allocated;
+
+	pthread_mutex_lock(&cache.lock);
+	if (cache.stats.rows >= cache.size && _nc_cache_grow()){
+		pthread_mutex_unlock(&cache.lock);
+		free(row);
+		return -1;
+	}
+	NcCacheRow **p = _nc_cache_find(owner, index);
+	NcCacheRow *old = *p ? _nc_cache_remove(*p) : NULL;
+	p = _nc_cache_find(owner, index);
+	row->chain = *p;
+	*p = row;
+	row->frame = cache.frame;
+	_nc_cache_push(row);
+	cache.stats.rows++;
+	cache.stats.bytes += row->bytes;
+	NcCacheRow *evicted = _nc_cache_evict();
+	pthread_mutex_unlock(&cache.lock);
+
+	if (old)
+		old->chain = NULL;
+	_nc_cache_free(old);
+	_nc_cache_free(evicted);
+	return 0;
+}
+
+void _nc_cache_drop(const void *owner)
+{
+	NcCacheRow *dropped = NULL, *row, *prev;
+	pthread_mutex_lock(&cache.lock);
+	for (row = cache.tail; row; row = prev) {
+		prev = row->prev;
+		if (row->owner != owner)
+			continue;
+		_nc_cache_remove(row);
+		row->chain = dropped;
+		dropped = row;
+	}
+	pthread_mutex_unlock(&cache.lock);
+	_nc_cache_free(dropped);
+}
+
+void _nc_cache_frame()
+{
+	pthread_mutex_lock(&cache.lock);
+	cache.frame++;
+	NcCacheRow *evicted = _nc_cache_evict();
+	pthread_mutex_unlock(&cache.lock);
+	_nc_cache_free(evicted);
+}
+
+void nc_cache_set_budget(size_t bytes)
+{
+	pthread_mutex_lock(&cache.lock);
+	cache.stats.budget = bytes;
+	NcCacheRow *evicted = _nc_cache_evict();
+	pthread_mutex_unlock(&cache.lock);
+	_nc_cache_free(evicted);
+}
+
+void nc_cache_stats(NcCacheStats *out)
+{
+	pthread_mutex_lock(&cache.lock);
+	*out = cache.stats;
+	pthread_mutex_unlock(&cache.lock);
+}
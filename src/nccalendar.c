@@ -2,7 +2,7 @@
  * File              : nccalendar.c
  * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
  * Date              : 29.06.2023
- * Last Modified Date: 09.05.2024
+ * Last Modified Date: 17.10.2026
  * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
  */
 
@@ -30,6 +30,15 @@ const char * nc_calendar_dnames[] =
 	mktime(&it);\
 	for (; it.tm_mon == tm->tm_mon; it.tm_mday++, mktime(&it))\
 
+/* put text to cells, text without attr if table of interned
+ * attributes is full */
+static int _nc_calendar_put(
+		u8char_t *cells, int pos, int max, const char *str, attr_t attr)
+{
+	int ret = _nc_cells_put(cells, pos, max, str, attr);
+	return ret < 0 ? _nc_cells_put(cells, pos, max, str, 0) : ret;
+}
+
 void nc_calendar_refresh(NcWidget *ncwidget)
 {
 	NcCalendar *nccalendar = (NcCalendar *)ncwidget;
@@ -44,12 +53,15 @@ void nc_calendar_refresh(NcWidget *ncwidget)
 	int i, h, w, y, x;
 	getmaxyx(nccalendar->ncwidget.ncwin.overlay, h, w);
 
-	// fill with blank 
-	for (y = 0; y < h - 2; ++y)
-		for (x = 0; x < w - 2; x++)
-			mvwaddch(nccalendar->ncwidget.ncwin.overlay, y+1, x+1, ' ');
+	// rows of calendar: month name and year, week names and
+	// up to 6 weeks 
+	int width = w - 2;
+	u8char_t rows[8][width > 0 ? width : 1];
+	for (y = 0; y < 8; ++y)
+		for (x = 0; x < width; ++x)
+			rows[y][x] = u8char_pack(' ', 0);
 	
-	// print month name
+	// month name
 	char mname[16];
 	strftime(mname, 16, "%B", tm);
 	int len = strchars(mname); 
@@ -57,27 +69,23 @@ void nc_calendar_refresh(NcWidget *ncwidget)
 	// get center of text (month name + year)
 	len += 5;
 	int start = w/2 - len/2;
+	if (start < 1)
+		start = 1;
 
-	if (ncwidget->focused && nccalendar->selected == nccalendar_selected_month)
-		wattron (nccalendar->ncwidget.ncwin.overlay, attr | A_REVERSE);
-	mvwaddstr(nccalendar->ncwidget.ncwin.overlay, 1, start, mname);
-	if (ncwidget->focused && nccalendar->selected == nccalendar_selected_month)
-		wattroff(nccalendar->ncwidget.ncwin.overlay, attr | A_REVERSE);
+	x = _nc_calendar_put(rows[0], start - 1, width, mname, 
+			ncwidget->focused && nccalendar->selected == nccalendar_selected_month 
+			? attr | A_REVERSE : 0);
 	
-	// print year
-	waddch(nccalendar->ncwidget.ncwin.overlay, ' ');
+	// year
 	char year[5];
 	sprintf(year, "%d", tm->tm_year + 1900);
-	if (ncwidget->focused && nccalendar->selected == nccalendar_selected_year)
-		wattron (nccalendar->ncwidget.ncwin.overlay, attr | A_REVERSE);
-	waddstr(nccalendar->ncwidget.ncwin.overlay, year);
-	if (ncwidget->focused && nccalendar->selected == nccalendar_selected_year)
-		wattroff(nccalendar->ncwidget.ncwin.overlay, attr | A_REVERSE);
+	_nc_calendar_put(rows[0], x + 1, width, year, 
+			ncwidget->focused && nccalendar->selected == nccalendar_selected_year
+			? attr | A_REVERSE : 0);
 	 
-	// print week names
-	wmove(nccalendar->ncwidget.ncwin.overlay, 2, 1);		
+	// week names
 	struct tm tw = *tm;
-	for (i = 0; i < 7; i++){
+	for (i = 0, x = 0; i < 7; i++){
 		tw.tm_wday = nccalendar->startofweek + i;
 		if (tw.tm_wday > 6)
 			tw.tm_wday = 0;
@@ -87,13 +95,11 @@ void nc_calendar_refresh(NcWidget *ncwidget)
 		int index = uchar_index(wname, 2);
 		wname[index] = 0;
 
-		waddstr(nccalendar->ncwidget.ncwin.overlay, wname);
-		if (i < 6)
-			waddch(nccalendar->ncwidget.ncwin.overlay, ' ');
+		x = _nc_calendar_put(rows[1], x, width, wname, 0) + 1;
 	}
 
-	// fill with dates
-	y = 3; 
+	// dates
+	y = 2; 
 	struct tm tp;
 	nc_calendar_iterate(tp, tm){
 		if (tp.tm_mday == 1){
@@ -101,23 +107,21 @@ void nc_calendar_refresh(NcWidget *ncwidget)
 			if (i < 0)
 				i += 7;
 		}
-		x = i*3 + 1;
-		if (ncwidget->focused 
+		_nc_calendar_put(rows[y], i*3, width, nc_calendar_dnames[tp.tm_mday],
+				ncwidget->focused 
 				&& nccalendar->selected == nccalendar_selected_day 
-				&& tp.tm_mday == tm->tm_mday)		
-			wattron (nccalendar->ncwidget.ncwin.overlay, attr | A_REVERSE);
-		mvwaddstr(nccalendar->ncwidget.ncwin.overlay, y, x, nc_calendar_dnames[tp.tm_mday]);
-		if (ncwidget->focused 
-				&& nccalendar->selected == nccalendar_selected_day 
-				&& tp.tm_mday == tm->tm_mday)		
-			wattroff(nccalendar->ncwidget.ncwin.overlay, attr | A_REVERSE);		
+				&& tp.tm_mday == tm->tm_mday ? attr | A_REVERSE : 0);
 		if (++i == 7){
 			i = 0;
 			y++;	
 		}
 	}
 
-	wrefresh(nccalendar->ncwidget.ncwin.overlay);
+	for (y = 0; y < h - 2; ++y)
+		_nc_paint_row(nccalendar->ncwidget.ncwin.overlay, y + 1, 1, width,
+				y < 8 ? rows[y] : NULL, width, 0, 0, -1);
+
+	_nc_frame_stage(&nccalendar->ncwidget.ncwin);
 }
 
 void nc_calendar_set_focused(NcWidget *ncwidget, bool focused)
@@ -129,7 +133,7 @@ void nc_calendar_set_focused(NcWidget *ncwidget, bool focused)
 
 void nc_calendar_set(NcCalendar *nccalendar, time_t time){
 	nccalendar->tm = localtime(&time);
-	nc_calendar_refresh((NcWidget*)nccalendar);
+	nc_widget_invalidate((NcWidget*)nccalendar);
 }
 
 time_t nc_calendar_get(NcCalendar *nccalendar){
@@ -148,7 +152,7 @@ void nc_calendar_activate(
 
 	chtype ch;
 	while (ch != CTRL('x')) {
-		ch = getch();
+		ch = nc_getch();
 		// stop execution if callback not NULL
 		if (callback){
 			NCRET ret = callback(ncwidget, userdata, ch);
@@ -350,6 +354,7 @@ nc_calendar_new(
 	nccalendar->tm = localtime(&time);
 
 	nccalendar->ncwidget.focused  = 0;
+	nccalendar->ncwidget.invalid  = 0;
 	nccalendar->selected = 0;
 	nccalendar->startofweek = startofweek;
 
@@ -0,0 +1,498 @@
+/**
+ * File              : ncdecoder.c
+ * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
+ * Date              : 17.10.2026
+ * Last Modified Date: 17.10.2026
+ * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
+ */
+
+#include "ncwidgets.h"
+#include "struct.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+NcDecoder *nc_decoder_new(int color,
+		void (*on_line)(void *userdata, NcText *line), void *userdata)
+{
+	NcDecoder *d = calloc(1, sizeof(NcDecoder));
+	if (!d)
+		return NULL;
+	d->color    = color;
+	d->attr     = A_NORMAL|COLOR_PAIR(color);
+	d->on_line  = on_line;
+	d->userdata = userdata;
+	d->state    = NcDecoderText;
+	d->fg       = -1;
+	d->bg       = -1;
+
+	d->aspans = 4;
+	d->spans  = malloc(d->aspans * sizeof(NcSpan));
+	if (!d->spans){
+		free(d);
+		return NULL;
+	}
+	d->nspans = 1;
+	d->spans[0].offset = 0;
+	d->spans[0].attr   = d->attr;
+	return d;
+}
+
+void nc_decoder_free(NcDecoder *d)
+{
+	if (!d)
+		return;
+	nc_text_free(d->pending);
+	free(d->bytes);
+	free(d->spans);
+	free(d);
+}
+
+static int _nc_decoder_put(
+		NcDecoder *d, const char *utf8, size_t len,
+		uint32_t chars, uint32_t cols)
+{
+	if (d->len + len + 1 > d->allocated){
+		size_t allocated = d->allocated ? d->allocated * 2 : 256;
+		if (allocated < d->len + len + 1)
+			allocated = d->len + len + 1;
+		char *ptr = realloc(d->bytes, allocated);
+		if (!ptr)
+			return -1;
+		d->bytes = ptr;
+		d->allocated = allocated;
+	}
+	memcpy(&d->bytes[d->len], utf8, len);
+	d->len   += len;
+	d->chars += chars;
+	d->cols  += cols;
+	return 0;
+}
+
+/* decode one char, invalid bytes are replaced with U+FFFD.
+ * Return number of bytes or -1 on error */
+static int _nc_decoder_char(NcDecoder *d, const char *str)
+{
+	uint32_t cp;
+	int k = utf8_decode(str, &cp);
+	char buf[4];
+	int ret = cp == U8CHAR_INVALID ?
+		_nc_decoder_put(d, buf, utf8_encode(cp, buf), 1, 1) :
+		_nc_decoder_put(d, str, k, 1, utf8_width(cp));
+	return ret ? -1 : k;
+}
+
+/* decode char cut by end of last chunk */
+static int _nc_decoder_part(NcDecoder *d)
+{
+	int i = 0;
+	d->part[d->npart] = 0;
+	while (i < d->npart) {
+		int k = _nc_decoder_char(d, &d->part[i]);
+		if (k < 0)
+			return -1;
+		i += k;
+	}
+	d->npart = 0;
+	return 0;
+}
+
+/* change attribute of empty span or start new one */
+static int _nc_decoder_attr(NcDecoder *d, attr_t attr)
+{
+	d->attr = attr;
+	NcSpan *last = &d->spans[d->nspans - 1];
+	if (last->offset == d->len){
+		last->attr = attr;
+		if (d->nspans > 1 && d->spans[d->nspans - 2].attr == attr)
+			d->nspans--;
+		return 0;
+	}
+	if (last->attr == attr)
+		return 0;
+
+	if (d->nspans == d->aspans){
+		NcSpan *ptr = realloc(d->spans, d->aspans * 2 * sizeof(NcSpan));
+		if (!ptr)
+			return -1;
+		d->spans = ptr;
+		d->aspans *= 2;
+	}
+	d->spans[d->nspans].offset = d->len;
+	d->spans[d->nspans++].attr = attr;
+	return 0;
+}
+
+static int _nc_decoder_tag(NcDecoder *d)
+{
+	attr_t attr = d->attr;
+	d->tag[d->ntag++] = '>';
+	d->tag[d->ntag] = 0;
+	_nc_markup_tag(d->tag, &attr, d->color);
+	d->state = NcDecoderText;
+	return _nc_decoder_attr(d, attr);
+}
+
+/* text of decoded chars of line */
+static NcText *_nc_decoder_text(NcDecoder *d)
+{
+	NcText *text = malloc(
+			sizeof(NcText) + d->nspans * sizeof(NcSpan) + d->len + 1);
+	if (!text)
+		return NULL;
+	text->len       = d->len;
+	text->chars     = d->chars;
+	text->cols      = d->cols;
+	text->allocated = d->len + 1;
+	text->index     = NULL;
+	text->refs      = 0;
+	text->next      = NULL;
+	text->nspans    = d->nspans;
+	memcpy(text->spans, d->spans, d->nspans * sizeof(NcSpan));
+	char *bytes = _nc_text_bytes(text);
+	if (d->len)
+		memcpy(bytes, d->bytes, d->len);
+	bytes[d->len] = 0;
+	return text;
+}
+
+static int _nc_decoder_line(NcDecoder *d)
+{
+	NcText *text = _nc_decoder_text(d);
+	if (!text)
+		return -1;
+	if (d->on_line)
+		d->on_line(d->userdata, text);
+	else
+		nc_text_free(text);
+
+	// markup attributes are set for line, ANSI attributes
+	// are kept as in terminal
+	d->len = d->chars = d->cols = 0;
+	if (!d->ansi)
+		d->attr = A_NORMAL|COLOR_PAIR(d->color);
+	d->nspans = 1;
+	d->spans[0].offset = 0;
+	d->spans[0].attr   = d->attr;
+	return 0;
+}
+
+/* color of pair for ANSI color 0-7 */
+static const short _nc_ansi_colors[8] = {7, 1, 2, 3, 4, 5, 6, 0};
+
+/* nearest of 8 colors for 24 bit color */
+static short _nc_ansi_rgb(int r, int g, int b)
+{
+	return _nc_ansi_colors[(r >= 128) | (g >= 128) << 1 | (b >= 128) << 2];
+}
+
+/* nearest of 8 colors for color of 256 colors palette */
+static short _nc_ansi_256(int n)
+{
+	if (n < 16)
+		return _nc_ansi_colors[n % 8];
+	if (n < 232){
+		n -= 16;
+		return _nc_ansi_rgb(n / 36 * 51, n / 6 % 6 * 51, n % 6 * 51);
+	}
+	return n < 244 ? _nc_ansi_colors[0] : _nc_ansi_colors[7];
+}
+
+/* apply SGR params to attribute */
+static int _nc_decoder_sgr(NcDecoder *d)
+{
+	attr_t attr = d->attr & ~A_COLOR;
+	int i;
+	if (!d->nparams)
+		d->params[d->nparams++] = 0;
+	for (i = 0; i < d->nparams; ++i) {
+		int p = d->params[i];
+		switch (p) {
+			case 0:
+				attr = A_NORMAL;
+				d->fg = d->bg = -1;
+				break;
+			case 1:  attr |= A_BOLD;       break;
+			case 2:  attr |= A_DIM;        break;
+#ifdef A_ITALIC
+			case 3:  attr |= A_ITALIC;     break;
+			case 23: attr &= ~A_ITALIC;    break;
+#endif
+			case 4:  attr |= A_UNDERLINE;  break;
+			case 5:  attr |= A_BLINK;      break;
+			case 7:  attr |= A_REVERSE;    break;
+			case 8:  attr |= A_INVIS;      break;
+			case 22: attr &= ~(A_BOLD|A_DIM); break;
+			case 24: attr &= ~A_UNDERLINE; break;
+			case 25: attr &= ~A_BLINK;     break;
+			case 27: attr &= ~A_REVERSE;   break;
+			case 28: attr &= ~A_INVIS;     break;
+			case 39: d->fg = -1;           break;
+			case 49: d->bg = -1;           break;
+			case 38: case 48:
+				{
+					short c = -1;
+					if (i + 2 < d->nparams && d->params[i + 1] == 5){
+						c = _nc_ansi_256(d->params[i + 2]);
+						i += 2;
+					} else if (i + 4 < d->nparams && d->params[i + 1] == 2){
+						c = _nc_ansi_rgb(d->params[i + 2], 
+								d->params[i + 3], d->params[i + 4]);
+						i += 4;
+					}
+					if (c >= 0 && p == 38)
+						d->fg = c;
+					else if (c >= 0)
+						d->bg = c;
+					break;
+				}
+			default:
+				if (p >= 30 && p <= 37)
+					d->fg = _nc_ansi_colors[p - 30];
+				else if (p >= 40 && p <= 47)
+					d->bg = _nc_ansi_colors[p - 40];
+				else if (p >= 90 && p <= 97)
+					d->fg = _nc_ansi_colors[p - 90];
+				else if (p >= 100 && p <= 107)
+					d->bg = _nc_ansi_colors[p - 100];
+				break;
+		}
+	}
+
+	// pairs are set by init_colors(): fg * 8 + bg + 1
+	if (d->fg < 0 && d->bg < 0)
+		attr |= COLOR_PAIR(d->color);
+	else {
+		short fg = d->color ? (d->color - 1) / 8 : 0;
+		short bg = d->color ? (d->color - 1) % 8 : 7;
+		if (d->fg >= 0)
+			fg = d->fg;
+		if (d->bg >= 0)
+			bg = d->bg;
+		attr |= COLOR_PAIR(fg * 8 + bg + 1);
+	}
+	return _nc_decoder_attr(d, attr);
+}
+
+/* parse byte of ANSI escape sequence */
+static int _nc_decoder_esc(NcDecoder *d, unsigned char c)
+{
+	switch (d->state) {
+		case NcDecoderEsc:
+			if (c == '['){
+				d->state = NcDecoderCsi;
+				d->nparams = 0;
+				d->params[0] = 0;
+				// ntag is set when params are given
+				d->ntag = 0;
+				d->marker = false;
+			} else if (c == ']')
+				d->state = NcDecoderOsc;
+			else if (c < 0x20 || c > 0x2F)
+				// intermediate bytes are skipped till final
+				d->state = NcDecoderText;
+			return 0;
+
+		case NcDecoderCsi:
+			if (c >= '0' && c <= '9'){
+				if (d->params[d->nparams] < 0xFFFF)
+					d->params[d->nparams] = 
+						d->params[d->nparams] * 10 + c - '0';
+				d->ntag = 1;
+			} else if (c == ';' || c == ':'){
+				if (d->nparams < NC_DECODER_PARAMS - 1)
+					d->params[++d->nparams] = 0;
+				d->ntag = 1;
+			} else if (c >= 0x3C && c <= 0x3F)
+				d->marker = true;
+			else if (c >= 0x40 && c <= 0x7E){
+				d->state = NcDecoderText;
+				// last param has no separator
+				if (d->ntag)
+					d->nparams++;
+				if (c == 'm' && !d->marker)
+					return _nc_decoder_sgr(d);
+			}
+			return 0;
+
+		case NcDecoderOsc:
+			// string till BEL or ESC backslash
+			if (c == '\a')
+				d->state = NcDecoderText;
+			else if (c == 0x1B)
+				d->state = NcDecoderOscEsc;
+			return 0;
+
+		default:
+			d->state = c == '\\' ? NcDecoderText : NcDecoderOsc;
+			return 0;
+	}
+}
+
+/* bytes of utf8 char with first byte c */
+static int _nc_decoder_need(unsigned char c)
+{
+	if (c >= 0xF0 && c <= 0xF4)
+		return 4;
+	if (c >= 0xE0 && c <= 0xEF)
+		return 3;
+	if (c >= 0xC2 && c <= 0xDF)
+		return 2;
+	return 1;
+}
+
+int nc_decoder_feed(NcDecoder *d, const char *bytes, size_t len)
+{
+	nc_text_free(d->pending);
+	d->pending = NULL;
+
+	size_t i = 0;
+	while (i < len) {
+		unsigned char c = bytes[i];
+
+		// finish char cut by last chunk
+		if (d->npart){
+			if ((c & 0xC0) == 0x80){
+				d->part[d->npart++] = c;
+				i++;
+				if (d->npart < d->need)
+					continue;
+			}
+			if (_nc_decoder_part(d))
+				return -1;
+			continue;
+		}
+
+		if (d->state == NcDecoderLess){
+			if (c == '/' || c == '!'){
+				d->tag[1] = c;
+				d->ntag = 2;
+				d->state = NcDecoderTag;
+				i++;
+				continue;
+			}
+			// not tag - less sign is char
+			d->state = NcDecoderText;
+			if (_nc_decoder_put(d, "<", 1, 1, 1))
+				return -1;
+			continue;
+		}
+
+		if (d->state >= NcDecoderEsc){
+			// new line ends broken sequence
+			if (c == '\n')
+				d->state = NcDecoderText;
+			else {
+				i++;
+				if (_nc_decoder_esc(d, c))
+					return -1;
+				continue;
+			}
+		}
+
+		if (d->state == NcDecoderTag){
+			if (c == '>'){
+				i++;
+				if (_nc_decoder_tag(d))
+					return -1;
+			} else if (c == '\n'){
+				// tag is not closed till end of line
+				if (_nc_decoder_tag(d))
+					return -1;
+			} else {
+				if (d->ntag < NC_DECODER_TAG + 2)
+					d->tag[d->ntag++] = c;
+				i++;
+			}
+			continue;
+		}
+
+		if (c == '\n'){
+			i++;
+			if (_nc_decoder_line(d))
+				return -1;
+			continue;
+		}
+
+		if (c == 0x1B && d->ansi){
+			i++;
+			d->state = NcDecoderEsc;
+			continue;
+		}
+
+		if (c == '<' && !d->ansi){
+			i++;
+			d->tag[0] = '<';
+			d->state = NcDecoderLess;
+			continue;
+		}
+
+		if (c < 0x80){
+			// ascii chars up to end of line or tag
+			const char *nl = memchr(&bytes[i], '\n', len - i);
+			size_t end = nl ? (size_t)(nl - bytes) : len;
+			size_t run = utf8_ascii_run(&bytes[i], end - i, 
+					d->ansi ? 0x1B : '<');
+			if (!run)
+				run = 1;
+			if (_nc_decoder_put(d, &bytes[i], run, run, run))
+				return -1;
+			i += run;
+			continue;
+		}
+
+		// keep char cut by chunk end
+		int need = _nc_decoder_need(c);
+		if (i + need > len){
+			size_t k = 1;
+			while (i + k < len && (bytes[i + k] & 0xC0) == 0x80)
+				k++;
+			if (i + k == len){
+				memcpy(d->part, &bytes[i], k);
+				d->npart = k;
+				d->need  = need;
+				break;
+			}
+		}
+
+		int k = _nc_decoder_char(d, &bytes[i]);
+		if (k < 0)
+			return -1;
+		i += k;
+	}
+	return 0;
+}
+
+int nc_decoder_finish(NcDecoder *d)
+{
+	nc_text_free(d->pending);
+	d->pending = NULL;
+
+	if (d->npart && _nc_decoder_part(d))
+		return -1;
+	if (d->state == NcDecoderLess){
+		d->state = NcDecoderText;
+		if (_nc_decoder_put(d, "<", 1, 1, 1))
+			return -1;
+	}
+	if (d->state == NcDecoderTag && _nc_decoder_tag(d))
+		return -1;
+	if (d->state >= NcDecoderEsc)
+		d->state = NcDecoderText;
+
+	if (d->len && _nc_decoder_line(d))
+		return -1;
+	return 0;
+}
+
+void nc_decoder_set_ansi(NcDecoder *d, bool ansi)
+{
+	d->ansi = ansi;
+}
+
+const NcText *nc_decoder_pending(NcDecoder *d)
+{
+	if (!d->pending)
+		d->pending = _nc_decoder_text(d);
+	return d->pending;
+}
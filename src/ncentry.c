@@ -2,7 +2,7 @@
  * File              : ncentry.c
  * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
  * Date              : 16.06.2023
- * Last Modified Date: 09.05.2024
+ * Last Modified Date: 17.10.2026
  * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
  */
 
@@ -18,88 +18,125 @@
 void nc_entry_refresh(NcWidget *ncwidget)
 {
 	NcEntry *ncentry = (NcEntry *)ncwidget;
-	int h, w, y, x;
+	int h, w, y;
 	getmaxyx(ncentry->ncwidget.ncwin.overlay, h, w);
 
-	u8char_t *str = ncentry->info; 
-
-	//scroll to position
+	//scroll to column of position
 	ncentry->ypos     = 0;
 	ncentry->xpos     = 0;	
 
 	int width = w-2, height = h-2;
+	size_t col = nc_text_col(ncentry->info, ncentry->position);
 	if (ncentry->multiline){
-		while (ncentry->position >= (height  + ncentry->ypos) * width)
-			ncentry->ypos++;
+		if (width > 0 && height > 0 && col >= (size_t)(height * width))
+			ncentry->ypos = col / width - height + 1;
 	} else {
-		while (ncentry->position >= width + ncentry->xpos)
-			ncentry->xpos ++;
+		if (width > 0 && col >= (size_t)width)
+			ncentry->xpos = col - width + 1;
 	}
 
-	// fill with blank 
-	for (y = 0; y < h-2; ++y)
-		for (x = 0; x < w - 2; x++)
-			mvwaddch(ncentry->ncwidget.ncwin.overlay, y+1, x+1, ' ');	
-
-	// move string start positions
-	size_t i = 0;
-	i += ncentry->ypos * width;
-	i += ncentry->xpos;
+	// move string start positions, wide char cut by scroll
+	// is not painted
+	col = ncentry->ypos * width + ncentry->xpos;
+	size_t i = nc_text_index_at(ncentry->info, col);
+	if (nc_text_col(ncentry->info, i) < col)
+		i++;
 	
+	NcTextIter it;
+	nc_text_iter(&it, ncentry->info, i);
+
 	// fill with data
 	int lines = ncentry->multiline ? h-2 : 1; 
-	bool has_position = false;
-	for (y = 0; y < lines; ++y) {
-		wmove(ncentry->ncwidget.ncwin.overlay, y + 1, 1);		
-		
-		for (x = 0; x < w - 2 && str[i].utf8[0]; ++x){
-			if (str[i].utf8[0] == '\n'){
-				i++;
-				if (ncentry->multiline)
-					break;
-			}
-			if (i == ncentry->position && ncwidget->focused){
-				wattron (ncentry->ncwidget.ncwin.overlay, str[i].attr | A_REVERSE);
-				waddstr (ncentry->ncwidget.ncwin.overlay, str[i].utf8);
-				wattroff(ncentry->ncwidget.ncwin.overlay, str[i].attr | A_REVERSE);
-				has_position = true;
-			} else
-				waddstr (ncentry->ncwidget.ncwin.overlay, str[i].utf8);
-			i++;
+	for (y = 0; y < h - 2; ++y) {
+		if (y >= lines){
+			_nc_paint_text(ncentry->ncwidget.ncwin.overlay, y + 1, 1, width,
+					NULL, 0, 0, 0, -1);
+			continue;
+		}
+
+		// get chars of row
+		NcTextIter end = it;
+		uint32_t cp;
+		attr_t attr;
+		int len = 0, cols = 0;
+		while (nc_text_next(&end, &cp, &attr)){
+			if (ncentry->multiline && cp == '\n')
+				break;
+			cols += utf8_width(cp);
+			if (cols > width)
+				break;
+			len++;
 		}
 		
-		if (i == ncentry->position && ncwidget->focused && !has_position && x < w - 2){
-			wattron (ncentry->ncwidget.ncwin.overlay, A_REVERSE);
-			waddch  (ncentry->ncwidget.ncwin.overlay, ' ');
-			wattroff(ncentry->ncwidget.ncwin.overlay, A_REVERSE);
-			has_position = true;
+		int cursor = -1;
+		if (ncwidget->focused && 
+				ncentry->position >= i && ncentry->position <= i + len)
+			cursor = ncentry->position - i;
+
+		_nc_paint_text(ncentry->ncwidget.ncwin.overlay, y + 1, 1, width,
+				&it, len, 0, 0, cursor);
+		
+		i += len;
+		end = it;
+		if (ncentry->multiline && nc_text_next(&end, &cp, &attr) && cp == '\n'){
+			it = end;
+			i++;
 		}
 	}
 
-	wrefresh(ncentry->ncwidget.ncwin.overlay);
+	_nc_frame_stage(&ncentry->ncwidget.ncwin);
 }
 
 void nc_entry_set_value(NcEntry *ncentry, const char *value)
 {
-	ncentry->info = str2ucharstr(value, ncentry->ncwidget.ncwin.color);
-	nc_entry_refresh((NcWidget*)ncentry);
+	NcText *info = nc_text_new(value, ncentry->ncwidget.ncwin.color);
+	if (!info)
+		return;
+	nc_text_free(ncentry->info);
+	ncentry->info = info;
+	if (ncentry->position > nc_text_chars(info))
+		ncentry->position = nc_text_chars(info);
+	nc_widget_invalidate((NcWidget*)ncentry);
 }
 
 char *nc_entry_get_value(NcEntry *ncentry){
-	return ucharstr2str(ncentry->info);
+	return nc_text_str(ncentry->info);
+}
+
+size_t nc_entry_copy_value(NcEntry *ncentry, char *buf, size_t len)
+{
+	const char *bytes = nc_text_bytes(ncentry->info);
+	size_t size = nc_text_len(ncentry->info);
+	if (!len)
+		return size;
+
+	// do not cut utf8 char
+	size_t n = size < len ? size : len - 1;
+	while (n < size && n && (bytes[n] & 0xC0) == 0x80)
+		n--;
+	memcpy(buf, bytes, n);
+	buf[n] = 0;
+	return size;
+}
+
+const char *nc_entry_get_view(NcEntry *ncentry, size_t *len)
+{
+	if (len)
+		*len = nc_text_len(ncentry->info);
+	return nc_text_bytes(ncentry->info);
 }
 
 void nc_entry_destroy(NcWidget *ncwidget)
 {
 	NcEntry *ncentry = (NcEntry*)ncwidget;
 	nc_win_destroy(&ncwidget->ncwin);
-	free(ncentry->info);
+	nc_text_free(ncentry->info);
 	free(ncentry);
 }
 
 void nc_entry_set_position(NcEntry *ncentry, size_t position){
 	ncentry->position = position;
-	nc_entry_refresh((NcWidget*)ncentry);
+	nc_widget_invalidate((NcWidget*)ncentry);
 }
 
 size_t nc_entry_get_position(NcEntry *ncentry){
@@ -112,54 +149,21 @@ void nc_entry_set_focused(NcWidget *ncwidget, bool focused){
 	nc_entry_refresh(ncwidget);
 }
 
-void nc_entry_add_char(NcEntry *ncentry, u8char_t ch)
+void nc_entry_add_char(NcEntry *ncentry, const char *utf8, int len)
 {
-	// create new buffer
-	size_t len = ucharstrlen(ncentry->info);
-	u8char_t *buf;
-	if (len * sizeof(u8char_t) >= ncentry->allocated)
-		buf = malloc(ncentry->allocated + BUFSIZ);
-	else
-		buf = malloc(ncentry->allocated + BUFSIZ);
-	if (!buf)
+	size_t chars = nc_text_chars(ncentry->info);
+	NcText *info = 
+		nc_text_insert(ncentry->info, ncentry->position, utf8, len);
+	if (!info)
 		return;
-	ncentry->allocated += BUFSIZ;
 
-	//put char
-	size_t i, k;
-	for (i = 0, k = 0; i < len; i++, k++) {
-		if (i == ncentry->position){
-			buf[k++] = ch;
-		}
-		buf[k] = ncentry->info[i];
-	}
-	
-	if (i == ncentry->position)
-		buf[k++] = ch;
-	
-	buf[k].utf8[0] = 0;
-
-	free(ncentry->info);
-	ncentry->info = buf;
-	ncentry->position++;
+	ncentry->info = info;
+	ncentry->position += nc_text_chars(info) - chars;
 }
 
 void nc_entry_remove_char(NcEntry *ncentry)
 {
-	// create new buffer
-	size_t len = ucharstrlen(ncentry->info);
-	u8char_t *buf = malloc(ncentry->allocated);
-
-	size_t i, k;
-	for (i = 0, k = 0; i < len; i++, k++) {
-		if (i == ncentry->position - 1)
-			i++;
-		buf[k] = ncentry->info[i];
-	}
-	buf[k].utf8[0] = 0;
-
-	free(ncentry->info);
-	ncentry->info = buf;
+	nc_text_remove(ncentry->info, ncentry->position - 1, 1);
 	ncentry->position--;
 }
 
@@ -175,7 +179,7 @@ void nc_entry_activate(
 
 	chtype ch;
 	while (ch != CTRL('x')) {
-		ch = getch();
+		ch = nc_getch();
 		// stop execution if callback not NULL
 		if (callback){
 			NCRET ret = callback(ncwidget, userdata, ch);
@@ -189,7 +193,7 @@ void nc_entry_activate(
 		switch (ch) {
 			case KEY_RIGHT:
 				{
-					size_t len = ucharstrlen(ncentry->info);
+					size_t len = nc_text_chars(ncentry->info);
 					if (ncentry->position < len){
 						ncentry->position++;
 						nc_entry_refresh(ncwidget);
@@ -204,7 +208,7 @@ void nc_entry_activate(
 					int h, w;
 					getmaxyx(ncentry->ncwidget.ncwin.overlay, h, w);
 					int width = w-2;
-					size_t len = ucharstrlen(ncentry->info);
+					size_t len = nc_text_chars(ncentry->info);
 					if (ncentry->position + width < len)
 						ncentry->position += width - 1;
 					else
@@ -246,7 +250,7 @@ void nc_entry_activate(
 					int h, w;
 					getmaxyx(ncentry->ncwidget.ncwin.overlay, h, w);
 					int width = w-2;
-					size_t len = ucharstrlen(ncentry->info);
+					size_t len = nc_text_chars(ncentry->info);
 					if (ncentry->position + width < len)
 						ncentry->position += width;
 					else
@@ -261,7 +265,7 @@ void nc_entry_activate(
 					int h, w;
 					getmaxyx(ncentry->ncwidget.ncwin.overlay, h, w);
 					int width = w-2, height = h - 2;					
-					size_t len = ucharstrlen(ncentry->info);
+					size_t len = nc_text_chars(ncentry->info);
 					if (ncentry->position + width * height < len)
 						ncentry->position += width * height;
 					else
@@ -309,19 +313,13 @@ void nc_entry_activate(
 			
 			case KEY_TAB:
 				{
-					u8char_t u8ch;
-					u8ch.utf8[0] = '\t'; 
-					u8ch.utf8[1] = 0; 
-					nc_entry_add_char(ncentry, u8ch);
+					nc_entry_add_char(ncentry, "\t", 1);
 					nc_entry_refresh(ncwidget);
 				}
 
 			case KEY_ENTER: case KEY_RETURN: case '\r':
 				{
-					u8char_t u8ch;
-					u8ch.utf8[0] = '\n'; 
-					u8ch.utf8[1] = 0; 
-					nc_entry_add_char(ncentry, u8ch);
+					nc_entry_add_char(ncentry, "\n", 1);
 					nc_entry_refresh(ncwidget);
 				}				
 
@@ -334,16 +332,14 @@ void nc_entry_activate(
 							getbegyx(ncentry->ncwidget.ncwin.overlay, y, x);
 							getmaxyx(ncentry->ncwidget.ncwin.overlay, h, w);
 							int width = w-2, height = h - 2;					
-							size_t len = ucharstrlen(ncentry->info);
+							size_t len = nc_text_chars(ncentry->info);
 							if (event.bstate & BUTTON1_PRESSED){
 								int selectedRow    = event.y - y - 1;
 								int selectedColumn = event.x - x - 1;
 
-								ncentry->position = (ncentry->ypos + selectedRow) * width;
-								ncentry->position += ncentry->xpos + selectedColumn;
-
-								if (ncentry->position > len)
-									ncentry->position = len;
+								ncentry->position = nc_text_index_at(ncentry->info,
+										(ncentry->ypos + selectedRow) * width + 
+										ncentry->xpos + selectedColumn);
 
 								nc_entry_refresh(ncwidget);
 								break;
@@ -362,7 +358,7 @@ void nc_entry_activate(
 								int h, w;
 								getmaxyx(ncentry->ncwidget.ncwin.overlay, h, w);
 								int width = w-2;
-								size_t len = ucharstrlen(ncentry->info);
+								size_t len = nc_text_chars(ncentry->info);
 								if (ncentry->position + width < len)
 									ncentry->position += width;
 								else
@@ -382,48 +378,29 @@ void nc_entry_activate(
 						beep();
 						break;
 					}
-					u8char_t u8ch;
-					u8ch.attr = COLOR_PAIR(ncentry->ncwidget.ncwin.color);
-					if (c >= 252){/* 6-bytes */
-						u8ch.utf8[0] = c; 
-						u8ch.utf8[1] = getch(); 
-						u8ch.utf8[2] = getch(); 
-						u8ch.utf8[3] = getch(); 
-						u8ch.utf8[4] = getch(); 
-						u8ch.utf8[5] = getch(); 
-						u8ch.utf8[6] = 0; 
-					} 
-					else if (c >= 248){/* 5-bytes */
-						u8ch.utf8[0] = c; 
-						u8ch.utf8[1] = getch(); 
-						u8ch.utf8[2] = getch(); 
-						u8ch.utf8[3] = getch(); 
-						u8ch.utf8[4] = getch(); 
-						u8ch.utf8[5] = 0; 
-					}
-					else if (c >= 240){/* 4-bytes */
-						u8ch.utf8[0] = c; 
-						u8ch.utf8[1] = getch(); 
-						u8ch.utf8[2] = getch(); 
-						u8ch.utf8[3] = getch(); 
-						u8ch.utf8[4] = 0; 
-					} 
-					else if (c >= 224){/* 3-bytes */
-						u8ch.utf8[0] = c; 
-						u8ch.utf8[1] = getch(); 
-						u8ch.utf8[2] = getch(); 
-						u8ch.utf8[3] = 0; 
+					// read rest bytes of multibyte char, byte
+					// which does not continue char is read
+					// again as next key - invalid bytes are
+					// added as U+FFFD
+					char buf[4] = {c};
+					int i, len = 1, need = 1;
+					if      (c >= 0xF0 && c <= 0xF4) /* 4-bytes */
+						need = 4;
+					else if (c >= 0xE0 && c <= 0xEF) /* 3-bytes */
+						need = 3;
+					else if (c >= 0xC2 && c <= 0xDF) /* 2-bytes */
+						need = 2;
+					for (i = 1; i < need; ++i) {
+						int next = getch();
+						if (next < 0x80 || next > 0xBF){
+							if (next != ERR)
+								ungetch(next);
+							break;
+						}
+						buf[len++] = next;
 					}
-					else if (c >= 192){/* 2-bytes */
-						u8ch.utf8[0] = c; 
-						u8ch.utf8[1] = getch(); 
-						u8ch.utf8[2] = 0; 
-					} 
-					else{/* 1-byte */
-						u8ch.utf8[0] = c; 
-						u8ch.utf8[1] = 0; 
-					} 
-					nc_entry_add_char(ncentry, u8ch);
+					
+					nc_entry_add_char(ncentry, buf, len);
 					nc_entry_refresh(ncwidget);
 				}
 		}
@@ -460,24 +437,21 @@ nc_entry_new(
 	ncentry->ypos     = 0;
 	ncentry->xpos     = 0;
 	ncentry->ncwidget.focused  = 0;
+	ncentry->ncwidget.invalid  = 0;
 
-	if (value && strlen(value)){
-		ncentry->allocated = strlen(value) * sizeof(u8char_t);
-		nc_entry_set_value(ncentry, value);
-		//set position
-		ncentry->position = ucharstrlen(ncentry->info);
-	} else {
-		ncentry->allocated = BUFSIZ;
-		ncentry->info = malloc(BUFSIZ);
-		if (!ncentry->info)
-			return NULL;
-		ncentry->info[0].utf8[0] = 0;
-	} 
+	ncentry->info = nc_text_new(value ? value : "", color);
+	if (!ncentry->info){
+		nc_entry_destroy((NcWidget*)ncentry);
+		return NULL;
+	}
+	//set position
+	ncentry->position = nc_text_chars(ncentry->info);
 
 	ncentry->ncwidget.on_refresh     = nc_entry_refresh;
 	ncentry->ncwidget.on_set_focused = nc_entry_set_focused;
 	ncentry->ncwidget.on_activate    = nc_entry_activate;
 	ncentry->ncwidget.on_destroy	   = nc_entry_destroy;
 
+	nc_widget_invalidate((NcWidget*)ncentry);
 	return (NcWidget*)ncentry;
 }
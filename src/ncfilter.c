@@ -0,0 +1,417 @@
+/**
+ * File              : ncfilter.c
+ * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
+ * Date              : 17.10.2026
+ * Last Modified Date: 17.10.2026
+ * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
+ */
+
+#include "ncwidgets.h"
+#include "struct.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* filter keeps text of all rows, so rows of borrowed lists
+ * are decoded once when filter is set first - virtual and
+ * async lists are not filtered, their rows are not read all.
+ * Query extended from previous one checks only rows matched
+ * before, other queries check rows with the rarest trigram
+ * of query or all rows for queries shorter than trigram */
+
+#define _nc_filter_hash(p) \
+	((((uint32_t)(unsigned char)(p)[0] << 16 | \
+	   (uint32_t)(unsigned char)(p)[1] << 8 | \
+	   (uint32_t)(unsigned char)(p)[2]) * 2654435761u) >> 16)
+
+uint64_t _nc_filter_mask(const char *str, size_t len)
+{
+	uint64_t mask = 0;
+	size_t i;
+	for (i = 0; i < len; ++i) {
+		unsigned char c = str[i];
+		if (c >= 'a' && c <= 'z')
+			mask |= 1ull << (c - 'a');
+		else if (c >= '0' && c <= '9')
+			mask |= 1ull << (26 + c - '0');
+		else
+			mask |= 1ull << (36 + c % 28);
+	}
+	return mask;
+}
+
+static void _nc_filter_fold(char *dst, const char *src, size_t len)
+{
+	size_t i;
+	for (i = 0; i < len; ++i)
+		dst[i] = src[i] >= 'A' && src[i] <= 'Z' ? src[i] + 32 : src[i];
+}
+
+static bool _nc_filter_find(
+		const char *str, size_t len, const char *query, size_t qlen)
+{
+	if (qlen > len)
+		return false;
+	const char *end = str + len - qlen + 1, *p = str;
+	while ((p = memchr(p, query[0], end - p))) {
+		if (!memcmp(p + 1, query + 1, qlen - 1))
+			return true;
+		p++;
+	}
+	return false;
+}
+
+static bool _nc_filter_match(NcListFilter *f, int row, uint64_t mask)
+{
+	return (f->masks[row] & mask) == mask && _nc_filter_find(&f->bytes[f->offsets[row]],
+			f->offsets[row + 1] - f->offsets[row], f->query, f->querylen);
+}
+
+/* text of source row - decoded for borrowed lists */
+static NcText *_nc_filter_text(NcList *nclist, int index, bool *owned)
+{
+	*owned = nclist->borrowed != NULL;
+	if (!nclist->borrowed)
+		return nclist->info[index];
+	if (!nclist->borrowed[index])
+		return NULL;
+	return nc_text_new(nclist->borrowed[index], nclist->ncwidget.ncwin.color);
+}
+
+/* add folded text of source row to end of filter bytes */
+static int _nc_filter_append(NcListFilter *f, NcList *nclist, int index)
+{
+	if (f->size + 2 > f->allocated_offsets){
+		int allocated = f->allocated_offsets * 2 > 16 ?
+			f->allocated_offsets * 2 : 16;
+		uint32_t *offsets = realloc(f->offsets, allocated * sizeof(uint32_t));
+		if (!offsets)
+			return -1;
+		f->offsets = offsets;
+		f->offsets[f->size] = f->nbytes;
+		uint64_t *masks = realloc(f->masks, allocated * sizeof(uint64_t));
+		if (!masks)
+			return -1;
+		f->masks = masks;
+		f->allocated_offsets = allocated;
+	}
+
+	bool owned;
+	NcText *text = _nc_filter_text(nclist, index, &owned);
+	size_t len = text ? text->len : 0;
+	if (f->nbytes + len + NC_FILTER_PAD > f->allocated){
+		size_t allocated = f->allocated * 2 > f->nbytes + len + NC_FILTER_PAD ?
+			f->allocated * 2 : f->nbytes + len + NC_FILTER_PAD;
+		char *bytes = realloc(f->bytes, allocated);
+		if (!bytes){
+			if (owned)
+				nc_text_free(text);
+			return -1;
+		}
+		f->bytes = bytes;
+		f->allocated = allocated;
+	}
+	if (text)
+		_nc_filter_fold(&f->bytes[f->nbytes], _nc_text_bytes(text), len);
+	if (owned)
+		nc_text_free(text);
+
+	f->masks[f->size] = _nc_filter_mask(&f->bytes[f->nbytes], len);
+	f->nbytes += len;
+	f->offsets[++f->size] = f->nbytes;
+	return 0;
+}
+
+/* build index of segment with rows first..first+count */
+static NcFilterSegment *_nc_filter_segment(
+		NcListFilter *f, int first, int count)
+{
+	// row has less trigrams than bytes
+	NcFilterSegment *seg = malloc(sizeof(NcFilterSegment) + 
+			(f->offsets[first + count] - f->offsets[first]) * sizeof(int));
+	int *last = malloc(NC_FILTER_BUCKETS * sizeof(int));
+	if (!seg || !last){
+		free(seg);
+		free(last);
+		return NULL;
+	}
+
+	// count rows of trigram, row with repeated trigram once
+	uint32_t i, total = 0;
+	int row, k;
+	for (k = 0; k < NC_FILTER_BUCKETS; ++k) {
+		seg->index[k] = 0;
+		last[k] = -1;
+	}
+	for (row = first; row < first + count; ++row) {
+		for (i = f->offsets[row]; i + 3 <= f->offsets[row + 1]; ++i) {
+			uint32_t h = _nc_filter_hash(&f->bytes[i]);
+			if (last[h] != row){
+				last[h] = row;
+				seg->index[h]++;
+			}
+		}
+	}
+	for (k = 0; k < NC_FILTER_BUCKETS; ++k) {
+		uint32_t n = seg->index[k];
+		seg->index[k] = total;
+		last[k] = total;
+		total += n;
+	}
+	seg->index[NC_FILTER_BUCKETS] = total;
+
+	for (row = first; row < first + count; ++row) {
+		for (i = f->offsets[row]; i + 3 <= f->offsets[row + 1]; ++i) {
+			uint32_t h = _nc_filter_hash(&f->bytes[i]);
+			if ((uint32_t)last[h] == seg->index[h] ||
+					seg->postings[last[h] - 1] != row)
+				seg->postings[last[h]++] = row;
+		}
+	}
+	free(last);
+	return seg;
+}
+
+/* index full segments of rows which have no index */
+static void _nc_filter_index(NcListFilter *f)
+{
+	while (f->size - f->nsegments * NC_FILTER_SEGMENT >= NC_FILTER_SEGMENT) {
+		NcFilterSegment **segments = realloc(f->segments,
+				(f->nsegments + 1) * sizeof(NcFilterSegment *));
+		if (!segments)
+			return;
+		f->segments = segments;
+		NcFilterSegment *seg = _nc_filter_segment(f, 
+				f->nsegments * NC_FILTER_SEGMENT, NC_FILTER_SEGMENT);
+		if (!seg)
+			return;
+		f->segments[f->nsegments++] = seg;
+	}
+}
+
+/* hash of query trigram with less rows in segment */
+static uint32_t _nc_filter_rarest(
+		NcFilterSegment *seg, const char *query, size_t len)
+{
+	uint32_t rarest = _nc_filter_hash(query);
+	size_t k;
+	for (k = 1; k + 3 <= len; ++k) {
+		uint32_t h = _nc_filter_hash(&query[k]);
+		if (seg->index[h + 1] - seg->index[h] < 
+				seg->index[rarest + 1] - seg->index[rarest])
+			rarest = h;
+	}
+	return rarest;
+}
+
+static int _nc_filter_grow_match(NcListFilter *f)
+{
+	if (f->size <= f->allocated_match)
+		return 0;
+	int allocated = f->allocated_match * 2 > f->size ?
+		f->allocated_match * 2 : f->size;
+	int *match = realloc(f->match, allocated * sizeof(int));
+	if (!match)
+		return -1;
+	f->match = match;
+	int *spare = realloc(f->spare, allocated * sizeof(int));
+	if (!spare)
+		return -1;
+	f->spare = spare;
+	f->allocated_match = allocated;
+	return 0;
+}
+
+static NcListFilter *_nc_filter_new(NcList *nclist)
+{
+	NcListFilter *f = calloc(1, sizeof(NcListFilter));
+	if (!f)
+		return NULL;
+	int i;
+	for (i = 0; i < nclist->size; ++i) {
+		if (_nc_filter_append(f, nclist, i))
+			break;
+	}
+	if (i < nclist->size || _nc_filter_grow_match(f)){
+		free(f->bytes);
+		free(f->offsets);
+		free(f->masks);
+		free(f->match);
+		free(f->spare);
+		free(f);
+		return NULL;
+	}
+	_nc_filter_index(f);
+	return f;
+}
+
+void _nc_list_filter_free(NcList *nclist)
+{
+	NcListFilter *f = nclist->filter;
+	if (!f)
+		return;
+	nclist->size = f->size;
+	// marked rows of fuzzy filter
+	_nc_cache_drop(f);
+	free(f->bytes);
+	free(f->offsets);
+	free(f->masks);
+	int i;
+	for (i = 0; i < f->nsegments; ++i)
+		free(f->segments[i]);
+	free(f->segments);
+	free(f->query);
+	free(f->match);
+	free(f->spare);
+	free(f->rank);
+	free(f->pos);
+	free(f);
+	nclist->filter = NULL;
+}
+
+int _nc_list_filter_add(NcList *nclist, int index)
+{
+	NcListFilter *f = nclist->filter;
+	if (_nc_filter_append(f, nclist, index) || _nc_filter_grow_match(f))
+		return -1;
+	_nc_filter_index(f);
+	if (!f->query)
+		nclist->size = f->size;
+	else if (nclist->fuzzy)
+		return _nc_list_fuzzy_add(nclist, index);
+	else if (_nc_filter_match(f, index, _nc_filter_mask(f->query, f->querylen))){
+		f->match[f->nmatch++] = index;
+		nclist->size = f->nmatch;
+	}
+	return 0;
+}
+
+int nc_list_set_filter(NcList *nclist, const char *query)
+{
+	// rows of virtual and async lists are not read all
+	if (nclist->async || nclist->fill)
+		return -1;
+
+	size_t len = query ? strlen(query) : 0;
+	if (!nclist->filter && !len)
+		return nclist->size;
+	if (!nclist->filter && !(nclist->filter = _nc_filter_new(nclist)))
+		return -1;
+
+	NcListFilter *f = nclist->filter;
+	char *q = NULL;
+	if (len){
+		q = malloc(len + 1);
+		if (!q)
+			return -1;
+		_nc_filter_fold(q, query, len);
+		q[len] = 0;
+	}
+
+	if (!q){
+		free(f->query);
+		f->query = NULL;
+		f->querylen = 0;
+		nclist->size = f->size;
+	} else if (nclist->fuzzy){
+		if (_nc_list_fuzzy(nclist, q, len))
+			return -1;
+	} else {
+		// query with previous one inside matches only its rows
+		const int *rows = NULL;
+		uint64_t mask = _nc_filter_mask(q, len);
+		int nrows = f->size, i, n = 0;
+		if (f->query && _nc_filter_find(q, len, f->query, f->querylen)){
+			rows  = f->match;
+			nrows = f->nmatch;
+		}
+
+		// rows with rarest trigram of query in every segment and
+		// rows after segments
+		int tail = f->nsegments * NC_FILTER_SEGMENT, count = f->size - tail;
+		if (len >= 3){
+			for (i = 0; i < f->nsegments; ++i) {
+				NcFilterSegment *seg = f->segments[i];
+				uint32_t h = _nc_filter_rarest(seg, q, len);
+				count += seg->index[h + 1] - seg->index[h];
+			}
+		}
+
+		free(f->query);
+		f->query = q;
+		f->querylen = len;
+		if (len >= 3 && count < nrows){
+			for (i = 0; i < f->nsegments; ++i) {
+				NcFilterSegment *seg = f->segments[i];
+				uint32_t h = _nc_filter_rarest(seg, q, len), k;
+				for (k = seg->index[h]; k < seg->index[h + 1]; ++k) {
+					if (_nc_filter_match(f, seg->postings[k], mask))
+						f->match[n++] = seg->postings[k];
+				}
+			}
+			for (i = tail; i < f->size; ++i) {
+				if (_nc_filter_match(f, i, mask))
+					f->match[n++] = i;
+			}
+		} else {
+			for (i = 0; i < nrows; ++i) {
+				int row = rows ? rows[i] : i;
+				if (_nc_filter_match(f, row, mask))
+					f->match[n++] = row;
+			}
+		}
+		f->nmatch = n;
+		nclist->size = n;
+	}
+
+	nclist->selected = 0;
+	nclist->ypos = 0;
+	nclist->xpos = 0;
+	_nc_list_mark_all(nclist);
+	nc_widget_invalidate((NcWidget*)nclist);
+	return nclist->size;
+}
+
+const char *nc_list_get_filter(NcList *nclist)
+{
+	return nclist->filter ? nclist->filter->query : NULL;
+}
+
+int nc_list_set_filtering(NcList *nclist, bool filtering)
+{
+	if (filtering && (nclist->async || nclist->fill))
+		return -1;
+
+	// text of rows and index are ready before first key
+	if (filtering && !nclist->filter &&
+			!(nclist->filter = _nc_filter_new(nclist)))
+		return -1;
+	nclist->filtering = filtering;
+	return 0;
+}
+
+void nc_list_set_fuzzy(NcList *nclist, int top, attr_t attr)
+{
+	nclist->fuzzy = top > 0 ? top : 0;
+	nclist->fuzzy_attr = attr;
+
+	// rows are filtered again by new mode
+	NcListFilter *f = nclist->filter;
+	if (f && f->query){
+		char *query = f->query;
+		f->query = NULL;
+		f->querylen = 0;
+		nclist->size = f->size;
+		nc_list_set_filter(nclist, query);
+		free(query);
+	}
+}
+
+int nc_list_get_source_row(NcList *nclist, int index)
+{
+	if (index < 0 || index >= nclist->size)
+		return -1;
+	if (nclist->filter && nclist->filter->query)
+		return nclist->fuzzy ? 
+			nclist->filter->rank[index].row : nclist->filter->match[index];
+	return index;
+}
@@ -0,0 +1,214 @@
+/**
+ * File              : ncframe.c
+ * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
+ * Date              : 17.10.2026
+ * Last Modified Date: 17.10.2026
+ * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
+ */
+
+#include "ncwidgets.h"
+#include "struct.h"
+#include <curses.h>
+#include <panel.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* interval of input polling while async rows are fetched, ms */
+#define NC_ASYNC_POLL 16
+
+/* list of invalid widgets */
+struct queue {
+	NcWidget **items;
+	int count;
+	int allocated;
+};
+
+/* frame state: widgets only stage their windows,
+ * terminal is flushed once in nc_frame_commit() */
+static struct {
+	bool pending;   // something staged since last flush
+	int  flushes;   // flushes in current frame
+	int  last;      // flushes in last finished frame
+	int  rate;      // max frames per second, 0 - no limit
+	double time;    // time of last flush
+	struct queue invalid;  // widgets to repaint in next frame
+	struct queue occluded; // invalid widgets covered by panels 
+} frame;
+
+static double _nc_frame_time()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static NcWidget *_nc_queue_remove(struct queue *q, int i)
+{
+	NcWidget *widget = q->items[i];
+	q->items[i] = q->items[--q->count];
+	return widget;
+}
+
+static bool _nc_queue_forget(struct queue *q, NcWin *ncwin)
+{
+	int i;
+	for (i = 0; i < q->count; ++i)
+		if ((void *)q->items[i] == (void *)ncwin){
+			_nc_queue_remove(q, i)->invalid = false;
+			return true;
+		}
+	return false;
+}
+
+static int _nc_queue_add(struct queue *q, NcWidget *widget)
+{
+	if (q->count == q->allocated){
+		int allocated = q->allocated ? q->allocated * 2 : 16;
+		void *ptr = realloc(q->items, allocated * sizeof(NcWidget *));
+		if (!ptr)
+			return -1;
+		q->items = ptr;
+		q->allocated = allocated;
+	}
+	q->items[q->count++] = widget;
+	return 0;
+}
+
+static void _nc_frame_forget(NcWin *ncwin)
+{
+	if (!_nc_queue_forget(&frame.invalid, ncwin))
+		_nc_queue_forget(&frame.occluded, ncwin);
+}
+
+void nc_widget_invalidate(NcWidget *widget)
+{
+	if (widget->invalid)
+		return;
+
+	if (_nc_queue_add(&frame.invalid, widget)){
+		// no memory to defer - paint now
+		nc_widget_refresh(widget);
+		return;
+	}
+	widget->invalid = true;
+}
+
+void _nc_frame_stage(NcWin *ncwin)
+{
+	// painted widget is valid now
+	_nc_frame_forget(ncwin);
+
+	// subwindows share memory with parent panel window -
+	// touch parent to let update_panels() copy changes
+	if (ncwin){
+		_nc_stats_stage(ncwin);
+		if (wgetparent(ncwin->overlay)){
+			wsyncup(ncwin->overlay);
+			untouchwin(ncwin->overlay);
+		}
+	}
+	frame.pending = true;
+}
+
+static void _nc_frame_flush()
+{
+	int i;
+
+	// cached rows painted in last frame can be dropped
+	_nc_cache_frame();
+
+	// occluded widgets are painted when panels above them are
+	// hidden or moved
+	for (i = frame.occluded.count - 1; i >= 0; --i) {
+		if (_nc_win_occluded(&frame.occluded.items[i]->ncwin))
+			continue;
+		NcWidget *widget = _nc_queue_remove(&frame.occluded, i);
+		if (_nc_queue_add(&frame.invalid, widget)){
+			// no memory to defer - paint now
+			widget->invalid = false;
+			nc_widget_refresh(widget);
+		}
+	}
+
+	// paint invalidated widgets, widgets with no visible cells
+	// keep invalid state
+	while (frame.invalid.count){
+		NcWidget *widget = 
+			_nc_queue_remove(&frame.invalid, frame.invalid.count - 1);
+		if (_nc_win_occluded(&widget->ncwin) &&
+				!_nc_queue_add(&frame.occluded, widget))
+			continue;
+		widget->invalid = false;
+		nc_widget_refresh(widget);
+	}
+
+	_nc_win_shadows();
+	update_panels();
+	doupdate();
+	_nc_stats_flush();
+	frame.pending = false;
+	frame.flushes++;
+	frame.time = _nc_frame_time();
+}
+
+void nc_frame_commit()
+{
+	_nc_frame_flush();
+}
+
+void nc_frame_set_rate(int fps)
+{
+	frame.rate = fps > 0 ? fps : 0;
+}
+
+bool nc_frame_update()
+{
+	_nc_list_async_poll();
+
+	if (!frame.pending && !frame.invalid.count)
+		return false;
+
+	if (frame.rate && 
+			_nc_frame_time() - frame.time < 1.0 / frame.rate)
+		return false;
+
+	_nc_frame_flush();
+	return true;
+}
+
+int nc_frame_flushes()
+{
+	return frame.last;
+}
+
+int nc_getch()
+{
+	// input event ends frame - flush without rate limit
+	if (frame.pending || frame.invalid.count)
+		_nc_frame_flush();
+	frame.last = frame.flushes;
+	frame.flushes = 0;
+
+	// paint rows of async lists while waiting for key, delay
+	// of application is kept - wait no longer than its timeout
+	int delay = wgetdelay(stdscr), waited = 0;
+	while (_nc_list_async_poll()) {
+		if (frame.pending || frame.invalid.count)
+			_nc_frame_flush();
+		int wait = NC_ASYNC_POLL;
+		if (delay >= 0 && delay - waited < wait)
+			wait = delay - waited;
+		timeout(wait);
+		int ch = getch();
+		timeout(delay);
+		if (ch != ERR)
+			return ch;
+		waited += wait;
+		if (delay >= 0 && waited >= delay)
+			return ERR;
+	}
+	if (frame.pending || frame.invalid.count)
+		_nc_frame_flush();
+
+	return getch();
+}
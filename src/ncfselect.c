@@ -2,7 +2,7 @@
  * File              : ncfselect.c
  * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
  * Date              : 08.05.2024
- * Last Modified Date: 10.05.2024
+ * Last Modified Date: 17.10.2026
  * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
  */
 #include "colors.h"
@@ -66,6 +66,10 @@ file_select_filter(const struct dirent *d){
 
 void nc_fselect_set_value(NcFselect *fselect)
 {
+	_nc_list_clear(&fselect->nclist);
+
+	int i;
+
 	fselect->nclist.info = 
 		malloc( 8 * fselect->count + 8);
 	if (!fselect->nclist.info){
@@ -74,7 +78,6 @@ void nc_fselect_set_value(NcFselect *fselect)
 	fselect->nclist.size = fselect->count;
 	
 	/* copy values */
-	int i;
 	for (i = 0; i < fselect->count; ++i) {
 		attr_t color;
 		switch (fselect->dirents[i]->d_type) {
@@ -92,11 +95,12 @@ void nc_fselect_set_value(NcFselect *fselect)
 				break;
 		}
 		fselect->nclist.info[i] = 
-			str2ucharstr(fselect->dirents[i]->d_name, 
+			nc_text_new(fselect->dirents[i]->d_name, 
 					color);
 	}
 
-	nc_widget_refresh((NcWidget*)fselect);
+	_nc_list_mark_all(&fselect->nclist);
+	nc_widget_invalidate((NcWidget*)fselect);
 }
 
 void nc_fselect_refresh(NcFselect *fselect, int selected)
@@ -123,7 +127,11 @@ void nc_fselect_set(NcFselect *fselect, const char *path){
 }
 
 char * nc_fselect_get(NcFselect *fselect){
-	int i = nc_list_get_selected(&fselect->nclist);
+	// selected row of filtered list is other entry
+	int i = nc_list_get_source_row(&fselect->nclist,
+			nc_list_get_selected(&fselect->nclist));
+	if (i < 0)
+		return NULL;
 	char *path = malloc(BUFSIZ);
 	if (!path)
 		return NULL;
@@ -147,8 +155,8 @@ NCRET nc_fselect_callback(
 	switch (key) {
 		case KEY_ENTER: case '\n': case '\r':
 			{
-				int selected = 
-						nc_list_get_selected(&fselect->nclist);
+				int selected = nc_list_get_source_row(&fselect->nclist,
+						nc_list_get_selected(&fselect->nclist));
 				if (selected >= 0){
 					if (is_dir(fselect->path, fselect->dirents[selected]))
 					{
@@ -200,13 +208,8 @@ NcWidget *nc_fselect_new(
 		)
 {
 	NcWidget *widget = 
-		nc_list_new(parent, NULL, h, w, y, x, color,
-			 	NULL, 0, box, shadow);
-	if (!widget)
-		return NULL;
-
-	// realoc
-	widget = realloc(widget, sizeof(NcFselect));
+		_nc_list_new(parent, NULL, h, w, y, x, color,
+			 	NULL, 0, box, shadow, sizeof(NcFselect));
 	if (!widget)
 		return NULL;
 	
@@ -0,0 +1,559 @@
+/**
+ * File              : ncfuzzy.c
+ * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
+ * Date              : 17.10.2026
+ * Last Modified Date: 17.10.2026
+ * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
+ */
+
+#include "ncwidgets.h"
+#include "struct.h"
+#include "utils.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* fuzzy filter shows rows with chars of query in the same
+ * order, best rows first. Rows are split to chunks which are
+ * scored by pool of workers and main thread, every thread
+ * keeps own best rows which are merged at end. Rows without
+ * some char of query are dropped by char mask of row before
+ * scoring, chars of query are found by their lead bytes with
+ * vector compares. Query and rows are matched by whole utf8
+ * chars */
+
+#define NC_FUZZY_CHUNK   4096 // rows of one task
+#define NC_FUZZY_THREADS 32
+
+typedef size_t (*NcFuzzyMatch)(const char *str, size_t len,
+		const char *query, size_t qlen, int *score, uint32_t *pos);
+
+typedef struct NcFuzzyJob {
+	const NcListFilter *f;
+	const char *query;
+	size_t len;
+	NcFuzzyMatch match;
+	uint64_t mask;
+	const int *rows;    // rows to score, NULL - all rows
+	int nrows;
+	int *out;           // matched rows of chunk c from out[c * CHUNK]
+	int *counts;        // matched rows of chunks
+	int nchunks;
+	int next;           // next chunk to score
+	int top;
+	NcFuzzyHit *heaps;  // best rows of every thread, top for thread
+	int *nheaps;
+	int slots;          // next thread slot
+} NcFuzzyJob;
+
+static struct {
+	pthread_t threads[NC_FUZZY_THREADS];
+	int nthreads;
+	int want;           // workers to start, -1 - by number of cpus
+	NcFuzzyJob *job;
+	unsigned long generation;
+	int running;        // workers on job
+	bool stop;
+	pthread_mutex_t lock;
+	pthread_cond_t start;
+	pthread_cond_t done;
+} pool = {
+	.want  = -1,
+	.lock  = PTHREAD_MUTEX_INITIALIZER,
+	.start = PTHREAD_COND_INITIALIZER,
+	.done  = PTHREAD_COND_INITIALIZER,
+};
+
+static bool _nc_fuzzy_delim(char c)
+{
+	return c == ' ' || c == '/' || c == '-' || c == '_' ||
+		c == '.' || c == ':' || c == '\\';
+}
+
+/* bytes of utf8 char by its lead byte */
+static size_t _nc_fuzzy_clen(char c)
+{
+	unsigned char b = c;
+	return b < 0xC0 ? 1 : b < 0xE0 ? 2 : b < 0xF0 ? 3 : 4;
+}
+
+/* query is split to chars by lead bytes - chars of query
+ * which are not utf8 match nothing */
+static bool _nc_fuzzy_valid(const char *query, size_t len)
+{
+	size_t i = 0, k;
+	while (i < len) {
+		if ((query[i] & 0xC0) == 0x80)
+			return false;
+		k = _nc_fuzzy_clen(query[i]);
+		if (i + k > len)
+			return false;
+		for (i++; --k; i++)
+			if ((query[i] & 0xC0) != 0x80)
+				return false;
+	}
+	return true;
+}
+
+/* index of first byte c in str from i or len. Row bytes of
+ * filter are followed by NC_FILTER_PAD bytes, so 32 or 16
+ * bytes are compared in one step with AVX2 or SSE2 and bytes
+ * after len are dropped from result */
+static size_t _nc_fuzzy_find(const char *str, size_t len, size_t i, char c)
+{
+#if defined(__AVX2__)
+	__m256i vc = _mm256_set1_epi8(c);
+	for (; i < len; i += 32) {
+		unsigned int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(
+					_mm256_loadu_si256((const __m256i *)&str[i]), vc));
+		if (mask)
+			return i + __builtin_ctz(mask) < len ?
+				i + __builtin_ctz(mask) : len;
+	}
+	return len;
+#elif defined(__SSE2__)
+	__m128i vc = _mm_set1_epi8(c);
+	for (; i < len; i += 16) {
+		unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(
+					_mm_loadu_si128((const __m128i *)&str[i]), vc));
+		if (mask)
+			return i + __builtin_ctz(mask) < len ?
+				i + __builtin_ctz(mask) : len;
+	}
+	return len;
+#else
+	const char *p = i < len ? memchr(&str[i], c, len - i) : NULL;
+	return p ? (size_t)(p - str) : len;
+#endif
+}
+
+/* match of ascii query - its bytes are chars and are never
+ * inside of other chars of row, so bytes are matched alone */
+static size_t _nc_fuzzy_bytes(const char *str, size_t len,
+		const char *query, size_t qlen, int *score, uint32_t *pos)
+{
+	// end of first match
+	size_t i = 0, j;
+	for (j = 0; j < qlen; ++j, ++i) {
+		i = _nc_fuzzy_find(str, len, i, query[j]);
+		if (i >= len)
+			return 0;
+	}
+
+	// shortest match with this end
+	const char *s = &str[i - 1];
+	for (j = qlen - 1;; --s) {
+		if (*s == query[j]){
+			if (!j)
+				break;
+			j--;
+		}
+	}
+
+	// chars at start of words and chars in row are better,
+	// gaps of chars are worse
+	int sc = 0, gap = 0;
+	bool consecutive = false;
+	const char *p;
+	for (j = 0, p = s; j < qlen; ++p) {
+		if (*p != query[j]){
+			if ((*p & 0xC0) != 0x80){
+				sc -= gap++ ? 1 : 3;
+				consecutive = false;
+			}
+			continue;
+		}
+		int bonus = p == str ? 10 : _nc_fuzzy_delim(p[-1]) ? 8 : 0;
+		sc += 16 + (j ? bonus : bonus * 2) + (consecutive ? 8 : 0);
+		if (pos)
+			pos[j] = p - str;
+		consecutive = true;
+		gap = 0;
+		j++;
+	}
+	*score = sc;
+	return qlen;
+}
+
+/* match of query with not ascii chars, rows are matched by
+ * whole utf8 chars */
+static size_t _nc_fuzzy_chars(const char *str, size_t len,
+		const char *query, size_t qlen, int *score, uint32_t *pos)
+{
+	// end of first match - lead bytes are never inside of
+	// other chars, rest bytes of char are compared after lead
+	// byte is found
+	size_t i = 0, j, k;
+	for (j = 0; j < qlen; j += k, i += k) {
+		k = _nc_fuzzy_clen(query[j]);
+		i = _nc_fuzzy_find(str, len, i, query[j]);
+		while (i < len && (i + k > len ||
+					memcmp(&str[i + 1], &query[j + 1], k - 1)))
+			i = _nc_fuzzy_find(str, len, i + 1, query[j]);
+		if (i >= len)
+			return 0;
+	}
+
+	// shortest match with this end
+	const char *s = &str[i];
+	for (j = qlen; j;) {
+		for (k = 1; (query[j - k] & 0xC0) == 0x80; ++k);
+		j -= k;
+		for (s -= k; *s != query[j] ||
+				memcmp(s + 1, &query[j + 1], k - 1); --s);
+	}
+
+	// equal lead bytes start chars of equal length
+	int sc = 0, gap = 0;
+	size_t n = 0;
+	bool consecutive = false;
+	const char *p;
+	for (j = 0, p = s; j < qlen; p += k) {
+		k = _nc_fuzzy_clen(*p);
+		if (*p != query[j] || memcmp(p + 1, &query[j + 1], k - 1)){
+			if ((*p & 0xC0) != 0x80){
+				sc -= gap++ ? 1 : 3;
+				consecutive = false;
+			}
+			k = 1;
+			continue;
+		}
+		int bonus = p == str ? 10 : _nc_fuzzy_delim(p[-1]) ? 8 : 0;
+		sc += 16 + (j ? bonus : bonus * 2) + (consecutive ? 8 : 0);
+		if (pos)
+			pos[n] = p - str;
+		n++;
+		consecutive = true;
+		gap = 0;
+		j += k;
+	}
+	*score = sc;
+	return n;
+}
+
+/* match of query chosen once for all rows, it finds chars of
+ * query in order in row bytes of filter and scores them, byte
+ * positions of chars are written to pos if not NULL. Match
+ * returns number of chars of query, 0 - no match */
+static NcFuzzyMatch _nc_fuzzy_match(const char *query, size_t len)
+{
+	return utf8_ascii_run(query, len, 0) == len ?
+		_nc_fuzzy_bytes : _nc_fuzzy_chars;
+}
+
+static bool _nc_fuzzy_better(const NcFuzzyHit *a, const NcFuzzyHit *b)
+{
+	if (a->score != b->score)
+		return a->score > b->score;
+	if (a->len != b->len)
+		return a->len < b->len;
+	return a->row < b->row;
+}
+
+static int _nc_fuzzy_compar(const void *a, const void *b)
+{
+	return _nc_fuzzy_better(a, b) ? -1 : _nc_fuzzy_better(b, a);
+}
+
+/* keep top best hits in heap with worst hit at root */
+static void _nc_fuzzy_push(NcFuzzyHit *heap, int *n, int top, NcFuzzyHit hit)
+{
+	int i;
+	if (*n < top){
+		for (i = (*n)++; i > 0; i = (i - 1) / 2) {
+			NcFuzzyHit *parent = &heap[(i - 1) / 2];
+			if (!_nc_fuzzy_better(parent, &hit))
+				break;
+			heap[i] = *parent;
+		}
+		heap[i] = hit;
+		return;
+	}
+	if (!_nc_fuzzy_better(&hit, &heap[0]))
+		return;
+	for (i = 0;;) {
+		int child = 2 * i + 1;
+		if (child >= top)
+			break;
+		if (child + 1 < top && _nc_fuzzy_better(&heap[child], &heap[child + 1]))
+			child++;
+		if (!_nc_fuzzy_better(&hit, &heap[child]))
+			break;
+		heap[i] = heap[child];
+		i = child;
+	}
+	heap[i] = hit;
+}
+
+/* score chunks of job until all are taken */
+static void _nc_fuzzy_run(NcFuzzyJob *job)
+{
+	const NcListFilter *f = job->f;
+
+	pthread_mutex_lock(&pool.lock);
+	int slot = job->slots++;
+	pthread_mutex_unlock(&pool.lock);
+	NcFuzzyHit *heap = &job->heaps[slot * job->top];
+	int *nheap = &job->nheaps[slot];
+
+	for (;;) {
+		pthread_mutex_lock(&pool.lock);
+		int c = job->next++;
+		pthread_mutex_unlock(&pool.lock);
+		if (c >= job->nchunks)
+			break;
+
+		int first = c * NC_FUZZY_CHUNK, i, n = 0;
+		int last = first + NC_FUZZY_CHUNK < job->nrows ?
+			first + NC_FUZZY_CHUNK : job->nrows;
+		int *out = &job->out[first];
+		for (i = first; i < last; ++i) {
+			int row = job->rows ? job->rows[i] : i;
+			if ((f->masks[row] & job->mask) != job->mask)
+				continue;
+			NcFuzzyHit hit;
+			hit.row = row;
+			hit.len = f->offsets[row + 1] - f->offsets[row];
+			if (!job->match(&f->bytes[f->offsets[row]], hit.len,
+						job->query, job->len, &hit.score, NULL))
+				continue;
+			out[n++] = row;
+			_nc_fuzzy_push(heap, nheap, job->top, hit);
+		}
+		job->counts[c] = n;
+	}
+}
+
+static void *_nc_fuzzy_worker(void *arg)
+{
+	// worker waits for job after its start
+	unsigned long generation = (uintptr_t)arg;
+	pthread_mutex_lock(&pool.lock);
+	for (;;) {
+		while (!pool.stop && pool.generation == generation)
+			pthread_cond_wait(&pool.start, &pool.lock);
+		if (pool.stop)
+			break;
+		generation = pool.generation;
+		NcFuzzyJob *job = pool.job;
+		pthread_mutex_unlock(&pool.lock);
+
+		_nc_fuzzy_run(job);
+
+		pthread_mutex_lock(&pool.lock);
+		if (!--pool.running)
+			pthread_cond_signal(&pool.done);
+	}
+	pthread_mutex_unlock(&pool.lock);
+	return NULL;
+}
+
+static void _nc_fuzzy_start()
+{
+	int want = pool.want;
+	if (want < 0){
+		// main thread scores too
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		want = cpus > 1 ? cpus - 1 : 0;
+	}
+	if (want > NC_FUZZY_THREADS)
+		want = NC_FUZZY_THREADS;
+	while (pool.nthreads < want &&
+			!pthread_create(&pool.threads[pool.nthreads], NULL,
+				_nc_fuzzy_worker, (void *)(uintptr_t)pool.generation))
+		pool.nthreads++;
+}
+
+void _nc_fuzzy_quit()
+{
+	int i;
+	pthread_mutex_lock(&pool.lock);
+	pool.stop = true;
+	pthread_cond_broadcast(&pool.start);
+	pthread_mutex_unlock(&pool.lock);
+	for (i = 0; i < pool.nthreads; ++i)
+		pthread_join(pool.threads[i], NULL);
+	pool.nthreads = 0;
+	pool.stop = false;
+}
+
+void nc_fuzzy_set_threads(int threads)
+{
+	_nc_fuzzy_quit();
+	pool.want = threads;
+}
+
+/* chars of old query are inside new one in the same order */
+static bool _nc_fuzzy_extends(
+		const char *query, size_t len, const char *old, size_t oldlen)
+{
+	size_t i = 0, j = 0, k;
+	while (i < len && j < oldlen) {
+		k = _nc_fuzzy_clen(query[i]);
+		if (k == _nc_fuzzy_clen(old[j]) && i + k <= len &&
+				j + k <= oldlen && !memcmp(&query[i], &old[j], k))
+			j += k;
+		i += k;
+	}
+	return j == oldlen;
+}
+
+int _nc_list_fuzzy(NcList *nclist, char *query, size_t len)
+{
+	NcListFilter *f = nclist->filter;
+	int top = nclist->fuzzy, i;
+	_nc_fuzzy_start();
+
+	NcFuzzyJob job = {0};
+	job.f     = f;
+	job.query = query;
+	job.len   = len;
+	job.match = _nc_fuzzy_match(query, len);
+	job.mask  = _nc_filter_mask(query, len);
+	job.nrows = _nc_fuzzy_valid(query, len) ? f->size : 0;
+	job.top   = top;
+
+	// query extended from previous one matches only its rows,
+	// invalid query matches nothing
+	if (job.nrows && f->query && _nc_fuzzy_extends(query, len, f->query, f->querylen)){
+		job.rows  = f->match;
+		job.nrows = f->nmatch;
+	}
+	job.out     = f->spare;
+	job.nchunks = (job.nrows + NC_FUZZY_CHUNK - 1) / NC_FUZZY_CHUNK;
+
+	int slots = pool.nthreads + 1;
+	NcFuzzyHit *rank = realloc(f->rank, top * sizeof(NcFuzzyHit));
+	if (rank)
+		f->rank = rank;
+	uint32_t *pos = realloc(f->pos, len * sizeof(uint32_t));
+	if (pos)
+		f->pos = pos;
+	job.counts = malloc((job.nchunks + 1) * sizeof(int));
+	job.heaps  = malloc(slots * top * sizeof(NcFuzzyHit));
+	job.nheaps = calloc(slots, sizeof(int));
+	if (!rank || !pos || !job.counts || !job.heaps || !job.nheaps){
+		free(job.counts);
+		free(job.heaps);
+		free(job.nheaps);
+		free(query);
+		return -1;
+	}
+
+	// workers start with new generation
+	pthread_mutex_lock(&pool.lock);
+	pool.job = &job;
+	pool.running = pool.nthreads;
+	pool.generation++;
+	pthread_cond_broadcast(&pool.start);
+	pthread_mutex_unlock(&pool.lock);
+
+	_nc_fuzzy_run(&job);
+
+	pthread_mutex_lock(&pool.lock);
+	while (pool.running)
+		pthread_cond_wait(&pool.done, &pool.lock);
+	pool.job = NULL;
+	pthread_mutex_unlock(&pool.lock);
+
+	// matched rows of chunks in order, ascending
+	int n = 0, c;
+	for (c = 0; c < job.nchunks; ++c) {
+		memmove(&f->spare[n], &f->spare[c * NC_FUZZY_CHUNK],
+				job.counts[c] * sizeof(int));
+		n += job.counts[c];
+	}
+	f->spare = f->match;
+	f->match = job.out;
+	f->nmatch = n;
+
+	// best rows of all threads
+	int nhits = 0;
+	for (i = 0; i < slots; ++i) {
+		memmove(&job.heaps[nhits], &job.heaps[i * top],
+				job.nheaps[i] * sizeof(NcFuzzyHit));
+		nhits += job.nheaps[i];
+	}
+	qsort(job.heaps, nhits, sizeof(NcFuzzyHit), _nc_fuzzy_compar);
+	f->nrank = nhits < top ? nhits : top;
+	memcpy(f->rank, job.heaps, f->nrank * sizeof(NcFuzzyHit));
+	free(job.counts);
+	free(job.heaps);
+	free(job.nheaps);
+
+	free(f->query);
+	f->query = query;
+	f->querylen = len;
+	nclist->size = f->nrank;
+
+	// marked rows of previous query
+	_nc_cache_drop(f);
+	return 0;
+}
+
+int _nc_list_fuzzy_add(NcList *nclist, int index)
+{
+	NcListFilter *f = nclist->filter;
+	NcFuzzyHit hit;
+	hit.row = index;
+	hit.len = f->offsets[index + 1] - f->offsets[index];
+	if (!_nc_fuzzy_valid(f->query, f->querylen))
+		return 0;
+	uint64_t mask = _nc_filter_mask(f->query, f->querylen);
+	NcFuzzyMatch match = _nc_fuzzy_match(f->query, f->querylen);
+	if ((f->masks[index] & mask) != mask ||
+			!match(&f->bytes[f->offsets[index]], hit.len,
+				f->query, f->querylen, &hit.score, NULL))
+		return 0;
+	f->match[f->nmatch++] = index;
+
+	// insert to shown rows if it is better than last one
+	int i = f->nrank;
+	while (i > 0 && _nc_fuzzy_better(&hit, &f->rank[i - 1]))
+		i--;
+	if (i >= nclist->fuzzy)
+		return 0;
+	int moved = f->nrank < nclist->fuzzy ? f->nrank - i : f->nrank - i - 1;
+	memmove(&f->rank[i + 1], &f->rank[i], moved * sizeof(NcFuzzyHit));
+	f->rank[i] = hit;
+	if (f->nrank < nclist->fuzzy)
+		f->nrank++;
+	nclist->size = f->nrank;
+
+	_nc_cache_drop(f);
+	_nc_list_mark_all(nclist);
+	return 0;
+}
+
+NcText *_nc_list_fuzzy_row(NcList *nclist, int index, bool *owned)
+{
+	NcListFilter *f = nclist->filter;
+	*owned = false;
+	NcText *text = _nc_cache_get(f, index);
+	if (text)
+		return text;
+
+	int row = f->rank[index].row, score;
+	NcText *src = _nc_list_source_row(nclist, row, owned);
+	NcFuzzyMatch match = _nc_fuzzy_match(f->query, f->querylen);
+	size_t npos = src && _nc_fuzzy_valid(f->query, f->querylen) ?
+		match(&f->bytes[f->offsets[row]],
+			f->offsets[row + 1] - f->offsets[row],
+			f->query, f->querylen, &score, f->pos) : 0;
+	if (!npos)
+		return src;
+
+	// source may give other row now
+	while (npos && f->pos[npos - 1] >= src->len)
+		npos--;
+	text = _nc_text_mark(src, f->pos, npos, nclist->fuzzy_attr);
+	if (!text)
+		return src;
+	if (*owned)
+		nc_text_free(src);
+
+	// no memory to cache - caller frees row after use
+	*owned = _nc_cache_put(f, index, text) != 0;
+	return text;
+}
@@ -2,27 +2,30 @@
  * File              : nc_init.c
  * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
  * Date              : 08.05.2024
- * Last Modified Date: 08.05.2024
+ * Last Modified Date: 17.10.2026
  * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
  */
 
 #include "ncwidgets.h"
+#include "struct.h"
 #include <locale.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
 
-void nc_init(
-		const char *locale,
-		int color
-		)
-{
-	if (!locale)
-		locale = "";
-	setlocale(LC_ALL, locale);
+/* headless terminal or terminal with statistics */
+static SCREEN *screen = NULL;
+static FILE *input  = NULL;
+static FILE *output = NULL;
+static FILE *counted = NULL; // output with statistics
+static int feed = -1; // write end of input pipe
+static int tty  = -1; // terminal of stdout with statistics
 
+static void _nc_setup(int color)
+{
 	#undef  NCURSES_MOUSE_VERSION
 	#define NCURSES_MOUSE_VERSION 2
 
-	initscr();
-
 	/* init colosrs */
 	start_color();	
 	init_colors();
@@ -45,7 +48,178 @@ void nc_init(
 	noecho();	
 }
 
+void nc_init(
+		const char *locale,
+		int color
+		)
+{
+	if (!locale)
+		locale = "";
+	setlocale(LC_ALL, locale);
+
+	initscr();
+	_nc_setup(color);
+}
+
+int nc_init_stats(
+		const char *locale,
+		int color
+		)
+{
+	// curses sets modes and size of terminal by stderr when
+	// stdout is not terminal
+	if (!isatty(STDOUT_FILENO) || !isatty(STDERR_FILENO))
+		return -1;
+
+	if (!locale)
+		locale = "";
+	setlocale(LC_ALL, locale);
+
+	tty = dup(STDOUT_FILENO);
+	if (tty < 0)
+		return -1;
+
+	// count output written to terminal
+	counted = _nc_stats_open(tty);
+	if (!counted){
+		close(tty);
+		tty = -1;
+		return -1;
+	}
+
+	// stdout is socket of statistics until nc_quit()
+	fflush(stdout);
+	if (dup2(fileno(counted), STDOUT_FILENO) < 0){
+		_nc_stats_close(counted);
+		close(tty);
+		tty = -1;
+		return -1;
+	}
+
+	screen = newterm(NULL, stdout, stdin);
+	if (!screen){
+		dup2(tty, STDOUT_FILENO);
+		_nc_stats_close(counted);
+		close(tty);
+		tty = -1;
+		return -1;
+	}
+	set_term(screen);
+
+	_nc_setup(color);
+	return 0;
+}
+
+int nc_init_headless(
+		const char *locale,
+		int color,
+		const char *term,
+		int lines, int cols,
+		const char *device
+		)
+{
+	if (!locale)
+		locale = "";
+	setlocale(LC_ALL, locale);
+
+	if (!term)
+		term = "xterm";
+	if (!device)
+		device = "/dev/null";
+
+	output = fopen(device, "w");
+	if (!output)
+		return -1;
+
+	// count output written to device
+	counted = _nc_stats_open(fileno(output));
+	if (!counted){
+		fclose(output);
+		return -1;
+	}
+
+	// input is pipe to feed keys
+	int fds[2];
+	if (pipe(fds)){
+		_nc_stats_close(counted);
+		fclose(output);
+		return -1;
+	}
+	input = fdopen(fds[0], "r");
+	if (!input){
+		close(fds[0]);
+		close(fds[1]);
+		_nc_stats_close(counted);
+		fclose(output);
+		return -1;
+	}
+	feed  = fds[1];
+
+	screen = newterm(term, counted, input);
+	if (!screen){
+		_nc_stats_close(counted);
+		fclose(input);
+		fclose(output);
+		close(feed);
+		return -1;
+	}
+	set_term(screen);
+
+	if (lines > 0 && cols > 0)
+		resize_term(lines, cols);
+
+	_nc_setup(color);
+
+	// input pipe is not tty - keep 8th bit of utf8 bytes
+	meta(stdscr, TRUE);
+	return 0;
+}
+
+int nc_headless_feed(const char *bytes, int len)
+{
+	if (feed < 0)
+		return -1;
+	return write(feed, bytes, len);
+}
+
+int nc_headless_feed_key(int key)
+{
+	if (key < KEY_MIN){
+		char c = key;
+		return nc_headless_feed(&c, 1);
+	}
+
+	// escape sequence of function key
+	char *seq = keybound(key, 0);
+	if (!seq)
+		return -1;
+	int ret = nc_headless_feed(seq, strlen(seq));
+	free(seq);
+	return ret;
+}
+
 void nc_quit()
 {
+	_nc_fuzzy_quit();
 	endwin();
+	if (screen && tty >= 0){
+		delscreen(screen);
+
+		// terminal back to stdout, reader forwards rest of
+		// output before it stops
+		fflush(stdout);
+		dup2(tty, STDOUT_FILENO);
+		_nc_stats_close(counted);
+		close(tty);
+		screen = NULL;
+		tty = -1;
+	} else if (screen){
+		delscreen(screen);
+		_nc_stats_close(counted);
+		fclose(input);
+		fclose(output);
+		close(feed);
+		screen = NULL;
+		feed = -1;
+	}
 }
@@ -0,0 +1,169 @@
+/**
+ * File              : ncintern.c
+ * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
+ * Date              : 17.10.2026
+ * Last Modified Date: 17.10.2026
+ * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
+ */
+
+#include "ncwidgets.h"
+#include "struct.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* interned texts are shared by all rows with the same bytes
+ * and spans. Table is chained by next pointer of text */
+
+static struct {
+	NcText **buckets;
+	uint32_t size;      // power of 2
+	uint32_t count;
+	bool rows;          // intern rows of lists and labels
+	NcInternStats stats;
+	pthread_mutex_t lock;
+} table = {NULL, 0, 0, false, {0}, PTHREAD_MUTEX_INITIALIZER};
+
+static size_t _nc_intern_size(const NcText *text)
+{
+	return sizeof(NcText) + text->nspans * sizeof(NcSpan) + text->allocated;
+}
+
+/* FNV-1a of spans and bytes */
+static uint32_t _nc_intern_hash(const NcText *text)
+{
+	const unsigned char *p = (const unsigned char *)text->spans;
+	size_t i, n = text->nspans * sizeof(NcSpan) + text->len;
+	uint32_t hash = 2166136261u;
+	for (i = 0; i < n; ++i)
+		hash = (hash ^ p[i]) * 16777619u;
+	return hash;
+}
+
+static bool _nc_intern_equal(const NcText *a, const NcText *b)
+{
+	return a->len == b->len && a->nspans == b->nspans &&
+		!memcmp(a->spans, b->spans,
+				a->nspans * sizeof(NcSpan) + a->len);
+}
+
+static int _nc_intern_grow()
+{
+	uint32_t size = table.size ? table.size * 2 : 256, i;
+	NcText **buckets = calloc(size, sizeof(NcText *));
+	if (!buckets)
+		return -1;
+	for (i = 0; i < table.size; ++i) {
+		NcText *text = table.buckets[i];
+		while (text) {
+			NcText *next = text->next;
+			text->next = buckets[text->hash & (size - 1)];
+			buckets[text->hash & (size - 1)] = text;
+			text = next;
+		}
+	}
+	free(table.buckets);
+	table.buckets = buckets;
+	table.size = size;
+	return 0;
+}
+
+NcText *nc_text_intern(const char *markup, int color)
+{
+	NcText *text = nc_text_new(markup, color);
+	if (!text)
+		return NULL;
+
+	// spans padding is compared - clear it
+	uint32_t i;
+	for (i = 0; i < text->nspans; ++i) {
+		NcSpan span = text->spans[i];
+		memset(&text->spans[i], 0, sizeof(NcSpan));
+		text->spans[i].offset = span.offset;
+		text->spans[i].attr   = span.attr;
+	}
+	text->hash = _nc_intern_hash(text);
+
+	pthread_mutex_lock(&table.lock);
+	NcText *shared = table.size ?
+		table.buckets[text->hash & (table.size - 1)] : NULL;
+	while (shared &&
+			(shared->hash != text->hash || !_nc_intern_equal(shared, text)))
+		shared = shared->next;
+
+	if (shared){
+		shared->refs++;
+		table.stats.refs++;
+		table.stats.saved += _nc_intern_size(shared);
+		pthread_mutex_unlock(&table.lock);
+		nc_text_free(text);
+		return shared;
+	}
+
+	if (table.count >= table.size && _nc_intern_grow()){
+		// no memory for table - text is not shared
+		pthread_mutex_unlock(&table.lock);
+		return text;
+	}
+
+	// shared text lives long - drop unused bytes
+	if (text->allocated > text->len + 1){
+		NcText *ptr = realloc(text,
+				sizeof(NcText) + text->nspans * sizeof(NcSpan) + text->len + 1);
+		if (ptr){
+			text = ptr;
+			text->allocated = text->len + 1;
+		}
+	}
+
+	text->refs = 1;
+	text->next = table.buckets[text->hash & (table.size - 1)];
+	table.buckets[text->hash & (table.size - 1)] = text;
+	table.count++;
+	table.stats.strings++;
+	table.stats.refs++;
+	table.stats.bytes += _nc_intern_size(text);
+	pthread_mutex_unlock(&table.lock);
+	return text;
+}
+
+void _nc_text_release(NcText *text)
+{
+	pthread_mutex_lock(&table.lock);
+	table.stats.refs--;
+	if (--text->refs){
+		table.stats.saved -= _nc_intern_size(text);
+		pthread_mutex_unlock(&table.lock);
+		return;
+	}
+
+	NcText **p = &table.buckets[text->hash & (table.size - 1)];
+	while (*p != text)
+		p = &(*p)->next;
+	*p = text->next;
+	table.count--;
+	table.stats.strings--;
+	table.stats.bytes -= _nc_intern_size(text);
+	pthread_mutex_unlock(&table.lock);
+
+	free(text->index);
+	free(text);
+}
+
+void nc_text_set_interning(bool rows)
+{
+	table.rows = rows;
+}
+
+NcText *_nc_text_row(const char *markup, int color)
+{
+	return table.rows ?
+		nc_text_intern(markup, color) : nc_text_new(markup, color);
+}
+
+void nc_text_intern_stats(NcInternStats *out)
+{
+	pthread_mutex_lock(&table.lock);
+	*out = table.stats;
+	pthread_mutex_unlock(&table.lock);
+}
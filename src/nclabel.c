@@ -2,7 +2,7 @@
  * File              : nclabel.c
  * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
  * Date              : 14.06.2023
- * Last Modified Date: 08.05.2024
+ * Last Modified Date: 17.10.2026
  * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
  */
 
@@ -14,33 +14,20 @@
 
 void nc_label_refresh(NcWidget *ncwidget){
 	NcLabel *nclabel = (NcLabel *)ncwidget;
-	int h, w, y, x;
+	int h, w, y;
 	getmaxyx(nclabel->ncwidget.ncwin.overlay, h, w);
 
-	// fill with blank 
-	for (y = 0; y < h - 2; ++y)
-		for (x = 0; x < w - 2; x++)
-			mvwaddch(nclabel->ncwidget.ncwin.overlay, y+1, x+1, ' ');
-	
-	//fill with data
-	for (y = 0; y < h - 2 && y < nclabel->lines; ++y) {
-		wmove(nclabel->ncwidget.ncwin.overlay, y + 1, 1);		
-		u8char_t *str = nclabel->info[y]; 
-		
-		for (x = 0; x < w - 2 && str[x].utf8[0]; ++x) {
-			if (nclabel->ncwidget.focused){
-				wattron (nclabel->ncwidget.ncwin.overlay, str[x].attr | A_REVERSE);
-				waddstr (nclabel->ncwidget.ncwin.overlay, str[x].utf8);	
-				wattroff(nclabel->ncwidget.ncwin.overlay, str[x].attr | A_REVERSE);
-			} else{
-				wattron (nclabel->ncwidget.ncwin.overlay, str[x].attr);
-				waddstr (nclabel->ncwidget.ncwin.overlay, str[x].utf8);	
-				wattroff(nclabel->ncwidget.ncwin.overlay, str[x].attr);
-			}
-		}
+	attr_t attr = nclabel->ncwidget.focused ? A_REVERSE : 0;
+	for (y = 0; y < h - 2; ++y){
+		NcTextIter it;
+		if (y < nclabel->lines && nclabel->info[y])
+			nc_text_iter(&it, nclabel->info[y], 0);
+		_nc_paint_text(nclabel->ncwidget.ncwin.overlay, y + 1, 1, w - 2, 
+				y < nclabel->lines && nclabel->info[y] ? &it : NULL, -1,
+				attr, 0, -1);
 	}
 
-	wrefresh(nclabel->ncwidget.ncwin.overlay);
+	_nc_frame_stage(&nclabel->ncwidget.ncwin);
 }
 
 void nc_label_destroy(NcWidget *ncwidget)
@@ -49,12 +36,26 @@ void nc_label_destroy(NcWidget *ncwidget)
 	nc_win_destroy(&nclabel->ncwidget.ncwin);
 	int i;
 	for (i = 0; i < nclabel->lines; ++i) {
-		free(nclabel->info[i]);
+		nc_text_free(nclabel->info[i]);
 	}
 	free(nclabel->info);
 	free(nclabel);
 }
 
+void nc_label_render(
+		NcLabel *nclabel, int line, 
+		const NcTemplate *tpl, const char *values[])
+{
+	if (line < 0 || line >= nclabel->lines)
+		return;
+
+	NcText *text = nc_template_render(tpl, nclabel->info[line], values);
+	if (!text)
+		return;
+	nclabel->info[line] = text;
+	nc_widget_invalidate((NcWidget*)nclabel);
+}
+
 void nc_label_set_focused(NcWidget *ncwidget, bool focused)
 {
 	NcLabel *nclabel = (NcLabel *)ncwidget;
@@ -75,7 +76,7 @@ void nc_label_activate(
 
 	chtype ch;
 	while (ch != CTRL('x')) {
-		ch = getch();
+		ch = nc_getch();
 		// stop execution if callback not NULL
 		if (callback){
 			NCRET ret = callback(ncwidget, userdata, ch);
@@ -105,7 +106,7 @@ NcWidget * nc_label_new(
 		strsplit(text, "\n", &tokens);
 	
 	// allocate multiline info
-	u8char_t **info;
+	NcText **info;
 	info = malloc( 8 * lines + 8);
 	if (!info)
 		return NULL;
@@ -113,8 +114,8 @@ NcWidget * nc_label_new(
 	/* copy values */
 	int i, maxlen = 0;
 	for (i = 0; i < lines; ++i) {
-		info[i] = str2ucharstr(tokens[i], color);
-		int len = ucharstrlen(info[i]);
+		info[i] = _nc_text_row(tokens[i], color);
+		int len = info[i] ? nc_text_cols(info[i]) : 0;
 		if (len > maxlen)
 			maxlen = len;
 	}
@@ -135,6 +136,7 @@ NcWidget * nc_label_new(
 	nclabel->info = info;
 	nclabel->lines = lines;
 	nclabel->ncwidget.focused = 0;
+	nclabel->ncwidget.invalid = 0;
 	
 	// free tokens
 	free(tokens);
@@ -2,7 +2,7 @@
  * File              : nclist.c
  * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
  * Date              : 12.06.2023
- * Last Modified Date: 09.05.2024
+ * Last Modified Date: 17.10.2026
  * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
  */
 
@@ -16,63 +16,165 @@
 #include <stdlib.h>
 #include <string.h>
 
+void _nc_list_mark_row(NcList *nclist, int index)
+{
+	int y = index - nclist->ypos;
+	if (nclist->dirty && y >= 0 && y < nclist->rows)
+		nclist->dirty[y] = true;
+}
+
+void _nc_list_mark_all(NcList *nclist)
+{
+	int y;
+	for (y = 0; nclist->dirty && y < nclist->rows; ++y)
+		nclist->dirty[y] = true;
+}
+
+NcText *_nc_list_row(NcList *nclist, int index, bool *owned)
+{
+	*owned = false;
+	if (index < 0 || index >= nclist->size)
+		return NULL;
+	if (nclist->filter && nclist->filter->query){
+		if (nclist->fuzzy)
+			return _nc_list_fuzzy_row(nclist, index, owned);
+		index = nclist->filter->match[index];
+	}
+	return _nc_list_source_row(nclist, index, owned);
+}
+
+NcText *_nc_list_source_row(NcList *nclist, int index, bool *owned)
+{
+	*owned = false;
+	if (nclist->async)
+		return _nc_list_async_row(nclist, index);
+	if (!nclist->borrowed && !nclist->fill)
+		return nclist->info[index];
+
+	NcText *text = _nc_cache_get(nclist, index);
+	if (text)
+		return text;
+	int color = nclist->ncwidget.ncwin.color;
+	if (nclist->fill){
+		char buf[BUFSIZ];
+		if (!nclist->fill(nclist->userdata, index, buf, sizeof(buf))){
+			buf[sizeof(buf) - 1] = 0;
+			text = _nc_text_row(buf, color);
+		}
+	} else if (nclist->borrowed[index])
+		text = _nc_text_row(nclist->borrowed[index], color);
+
+	// no memory to cache - caller frees row after use
+	if (text && _nc_cache_put(nclist, index, text))
+		*owned = true;
+	return text;
+}
+
+void _nc_list_clear(NcList *nclist)
+{
+	int i;
+	_nc_list_filter_free(nclist);
+	for (i = 0; nclist->info && i < nclist->size; ++i)
+		nc_text_free(nclist->info[i]);
+	free(nclist->info);
+	_nc_list_async_free(nclist);
+	nclist->info = NULL;
+	nclist->borrowed = NULL;
+	nclist->fill = NULL;
+	nclist->size = 0;
+	nclist->allocated = 0;
+	_nc_cache_drop(nclist);
+}
+
+static void _nc_list_refresh_row(NcList *nclist, int y, int w)
+{
+	NcWidget *ncwidget = (NcWidget *)nclist;
+	int index = y + nclist->ypos;
+	bool owned;
+	NcText *text = _nc_list_row(nclist, index, &owned);
+
+	if (!text){
+		_nc_paint_text(nclist->ncwidget.ncwin.overlay, y + 1, 1, w - 2,
+				NULL, 0, 0, 0, -1);
+		return;
+	}
+
+	NcTextIter it;
+	if (index == nclist->selected && ncwidget->focused){
+		// move chars for xpos columns, wide char cut by
+		// scroll is not painted
+		size_t i = nc_text_index_at(text, nclist->xpos);
+		if (nc_text_col(text, i) < (size_t)nclist->xpos)
+			i++;
+		nc_text_iter(&it, text, i);
+		_nc_paint_text(nclist->ncwidget.ncwin.overlay, y + 1, 1, w - 2,
+				&it, -1, A_REVERSE, A_REVERSE, -1);
+	} else {
+		nc_text_iter(&it, text, 0);
+		_nc_paint_text(nclist->ncwidget.ncwin.overlay, y + 1, 1, w - 2,
+				&it, -1, 0, 0, -1);
+	}
+	if (owned)
+		nc_text_free(text);
+}
+
 void nc_list_refresh(NcWidget *ncwidget)
 {
 	NcList *nclist = (NcList*)ncwidget;
 
-	int h, w, y, x;
+	int h, w, y;
 	getmaxyx(nclist->ncwidget.ncwin.overlay, h, w);
 
 	if (nclist->selected < 0)
 		nclist->selected = 0;
 
-	//scroll to selected
-	while (nclist->selected > h-2 + nclist->ypos - 2 && 
+	//scroll to selected - jump, list may have millions of rows
+	if (nclist->selected > h-2 + nclist->ypos - 2 && 
 			nclist->selected + 1 < nclist->size)
-		nclist->ypos++;
+		nclist->ypos = nclist->selected - (h-2 - 2);
 
-	while (nclist->selected < nclist->ypos + 1 
+	if (nclist->selected < nclist->ypos + 1 
 			&& nclist->selected > 0)
-		nclist->ypos--;
-
-	// fill with blank 
-	for (y = 0; y < h - 2; ++y)
-		for (x = 0; x < w - 2; x++)
-			if (y + nclist->ypos == nclist->selected 
-					&& ncwidget->focused)
-				mvwaddch(nclist->ncwidget.ncwin.overlay, y+1, x+1, ' '|A_REVERSE);
-			else		
-				mvwaddch(nclist->ncwidget.ncwin.overlay, y+1, x+1, ' ');
-	
-	//fill with data
-	for (y = 0; y < h - 2 && y < nclist->size; ++y) {
-		wmove(nclist->ncwidget.ncwin.overlay, y + 1, 1);		
-		u8char_t *str = nclist->info[y + nclist->ypos]; 
-		
-		if (y + nclist->ypos == nclist->selected && 
-				ncwidget->focused){
-			// move chars for xpos
-			str = &str[nclist->xpos];
-
-			for (x = 0; x < w - 2 && str[x].utf8[0]; ++x) {
-				if (str[x].utf8[0] == '\n') str[x].utf8[0] = ' ';
-				if (str[x].utf8[0] == '\r') str[x].utf8[0] = ' ';
-				wattron(nclist->ncwidget.ncwin.overlay, str[x].attr | A_REVERSE);
-				waddstr(nclist->ncwidget.ncwin.overlay, str[x].utf8);	
-				wattroff(nclist->ncwidget.ncwin.overlay, str[x].attr| A_REVERSE);
-			}
-		} else {
-			for (x = 0; x < w - 2 && str[x].utf8[0]; ++x) {
-				if (str[x].utf8[0] == '\n') str[x].utf8[0] = ' ';
-				if (str[x].utf8[0] == '\r') str[x].utf8[0] = ' ';
-				wattron(nclist->ncwidget.ncwin.overlay, str[x].attr);
-				waddstr(nclist->ncwidget.ncwin.overlay, str[x].utf8);	
-				wattroff(nclist->ncwidget.ncwin.overlay, str[x].attr);
-			}
-		}
+		nclist->ypos = nclist->selected - 1;
+
+	// resized - repaint all
+	if (nclist->rows != h - 2 || nclist->cols != w - 2){
+		bool *dirty = realloc(nclist->dirty, 
+				(h > 2 ? h - 2 : 1) * sizeof(bool));
+		if (!dirty)
+			return;
+		nclist->dirty = dirty;
+		nclist->rows  = h - 2;
+		nclist->cols  = w - 2;
+		_nc_list_mark_all(nclist);
 	}
 
-	wrefresh(nclist->ncwidget.ncwin.overlay);
+	// scrolled - repaint all
+	if (nclist->ypos != nclist->drawn_ypos)
+		_nc_list_mark_all(nclist);
+
+	// selection changed - repaint old and new rows
+	if (nclist->selected != nclist->drawn_selected ||
+			nclist->xpos != nclist->drawn_xpos ||
+			ncwidget->focused != nclist->drawn_focused)
+	{
+		_nc_list_mark_row(nclist, nclist->drawn_selected);
+		_nc_list_mark_row(nclist, nclist->selected);
+	}
+
+	for (y = 0; y < nclist->rows; ++y) {
+		if (!nclist->dirty[y])
+			continue;
+		_nc_list_refresh_row(nclist, y, w);
+		nclist->dirty[y] = false;
+	}
+
+	nclist->drawn_selected = nclist->selected;
+	nclist->drawn_ypos     = nclist->ypos;
+	nclist->drawn_xpos     = nclist->xpos;
+	nclist->drawn_focused  = ncwidget->focused;
+
+	_nc_frame_stage(&nclist->ncwidget.ncwin);
 }
 
 void nc_list_set_value(NcList *nclist, char **value, int size)
@@ -82,25 +184,82 @@ void nc_list_set_value(NcList *nclist, char **value, int size)
 
 void _nc_list_set_value(NcList *nclist, char **value, int size)
 {
+	_nc_list_clear(nclist);
+
+	int i;
 	nclist->info = malloc( 8 * size + 8);
 	if (!nclist->info){
 		return;
 	}
 	nclist->size = size;
+	nclist->allocated = size + 1;
 	
 	/* copy values */
-	int i;
 	for (i = 0; i < nclist->size; ++i) {
 		nclist->info[i] = 
-			str2ucharstr(value[i], nclist->ncwidget.ncwin.color);
+			_nc_text_row(value[i], nclist->ncwidget.ncwin.color);
+	}
+
+	_nc_list_mark_all(nclist);
+	nc_widget_invalidate((NcWidget*)nclist);
+}
+
+void nc_list_set_borrowed(NcList *nclist, const char **value, int size)
+{
+	_nc_list_clear(nclist);
+	nclist->borrowed = value;
+	nclist->size = value ? size : 0;
+
+	_nc_list_mark_all(nclist);
+	nc_widget_invalidate((NcWidget*)nclist);
+}
+
+void nc_list_set_source(
+		NcList *nclist, int size, NcListFill fill, void *userdata)
+{
+	_nc_list_clear(nclist);
+	nclist->fill = fill;
+	nclist->userdata = userdata;
+	nclist->size = fill ? size : 0;
+
+	_nc_list_mark_all(nclist);
+	nc_widget_invalidate((NcWidget*)nclist);
+}
+
+int nc_list_append(NcList *nclist, NcText *row)
+{
+	if (nclist->borrowed || nclist->fill || nclist->async)
+		return -1;
+
+	// grow twice to add rows by one
+	int size = nclist->filter ? nclist->filter->size : nclist->size;
+	if (size + 1 > nclist->allocated){
+		int allocated = size * 2 > 16 ? size * 2 : 16;
+		NcText **info = realloc(nclist->info, allocated * sizeof(NcText *));
+		if (!info)
+			return -1;
+		nclist->info = info;
+		nclist->allocated = allocated;
+	}
+	nclist->info[size] = row;
+
+	// filtered list shows row if it matches
+	if (!nclist->filter)
+		nclist->size++;
+	else if (_nc_list_filter_add(nclist, size)){
+		_nc_list_filter_free(nclist);
+		nclist->size++;
+		_nc_list_mark_all(nclist);
 	}
 
-	nc_list_refresh((NcWidget*)nclist);
+	_nc_list_mark_row(nclist, nclist->size - 1);
+	nc_widget_invalidate((NcWidget*)nclist);
+	return 0;
 }
 
 void nc_list_set_selected(NcList *nclist, int index){
 	nclist->selected = index;
-	nc_list_refresh((NcWidget*)nclist);
+	nc_widget_invalidate((NcWidget*)nclist);
 }
 
 int nc_list_get_selected(NcList *nclist){
@@ -126,7 +285,7 @@ void nc_list_activate(
 
 	chtype ch;
 	while (ch != CTRL('x')) {
-		ch = getch();
+		ch = nc_getch();
 		// stop execution if callback not NULL
 		if (callback){
 			NCRET ret = callback(ncwidget, userdata, ch);
@@ -140,9 +299,11 @@ void nc_list_activate(
 		switch (ch) {
 			case KEY_RIGHT:
 				{
-					u8char_t *str = nclist->info[nclist->selected];
-					str = &str[nclist->xpos];
-					int len = ucharstrlen(str); 
+					bool owned;
+					NcText *str = _nc_list_row(nclist, nclist->selected, &owned);
+					int len = str ? nc_text_cols(str) - nclist->xpos : 0;
+					if (owned)
+						nc_text_free(str);
 					int h, w;
 					getmaxyx(nclist->ncwidget.ncwin.overlay, h, w);					
 					if (len < w - 1){
@@ -260,7 +421,50 @@ void nc_list_activate(
 					break;
 				}
 
+			case KEY_BACKSPACE: case KEY_DELETE:
+				{
+					const char *query = nc_list_get_filter(nclist);
+					if (!nclist->filtering || !query){
+						beep();
+						break;
+					}
+					// query of application may be longer than
+					// buffer of typed one - remove last utf8 char
+					// in copy on heap
+					size_t len = strlen(query);
+					while (len && (query[--len] & 0xC0) == 0x80);
+					char *buf = malloc(len + 1);
+					if (!buf){
+						beep();
+						break;
+					}
+					memcpy(buf, query, len);
+					buf[len] = 0;
+					nc_list_set_filter(nclist, buf);
+					free(buf);
+					nc_list_refresh(ncwidget);	
+					break;
+				}
+
 			default:
+				// type to filter rows
+				if (nclist->filtering && ch >= ' ' && ch < 127){
+					const char *query = nc_list_get_filter(nclist);
+					char buf[BUFSIZ];
+					size_t len = query ? strlen(query) : 0;
+					if (len + 2 > sizeof(buf)){
+						beep();
+						break;
+					}
+					if (len)
+						memcpy(buf, query, len);
+					buf[len] = ch;
+					buf[len + 1] = 0;
+					if (nc_list_set_filter(nclist, buf) < 0)
+						beep();
+					nc_list_refresh(ncwidget);	
+					break;
+				}
 				beep();
 				break;
 		}
@@ -273,15 +477,12 @@ void nc_list_destroy(NcWidget *ncwidget)
 {
 	NcList *nclist = (NcList*)ncwidget;
 	nc_win_destroy(&ncwidget->ncwin);
-	int i;
-	for (i = 0; i < nclist->size; ++i) {
-		free(nclist->info[i]);
-	}
-	free(nclist->info);
+	_nc_list_clear(nclist);
+	free(nclist->dirty);
 	free(nclist);
 }
 
-NcWidget * nc_list_new(
+NcWidget * _nc_list_new(
 		NcWin *parent,
 		const char *title,
 		int h, int w, int y, int x,
@@ -289,7 +490,8 @@ NcWidget * nc_list_new(
 		char **value,
 		int size,
 		bool box,
-		bool shadow
+		bool shadow,
+		size_t allocated
 		)
 {
 	NcList *nclist =  
@@ -297,7 +499,7 @@ NcWidget * nc_list_new(
 	if (!nclist)
 		return NULL;
 
-	nclist = realloc(nclist, sizeof(NcList));
+	nclist = realloc(nclist, allocated);
 	if (!nclist)
 		return NULL;
 	
@@ -307,6 +509,26 @@ NcWidget * nc_list_new(
 	nclist->ypos     = 0;
 	nclist->xpos     = 0;
 	nclist->ncwidget.focused  = 0;
+	nclist->ncwidget.invalid  = 0;
+
+	nclist->info     = NULL;
+	nclist->size     = 0;
+	nclist->allocated = 0;
+	nclist->borrowed = NULL;
+	nclist->fill     = NULL;
+	nclist->userdata = NULL;
+	nclist->async    = NULL;
+	nclist->filter   = NULL;
+	nclist->filtering = false;
+	nclist->fuzzy    = 0;
+	nclist->fuzzy_attr = 0;
+	nclist->dirty    = NULL;
+	nclist->rows     = 0;
+	nclist->cols     = 0;
+	nclist->drawn_selected = 0;
+	nclist->drawn_ypos     = 0;
+	nclist->drawn_xpos     = 0;
+	nclist->drawn_focused  = 0;
 
 	nclist->ncwidget.on_refresh     = nc_list_refresh;
 	nclist->ncwidget.on_set_focused = nc_list_set_focused;
@@ -319,3 +541,38 @@ NcWidget * nc_list_new(
 
 	return (NcWidget*)nclist;
 }
+
+NcWidget * nc_list_new(
+		NcWin *parent,
+		const char *title,
+		int h, int w, int y, int x,
+		int color,
+		char **value,
+		int size,
+		bool box,
+		bool shadow
+		)
+{
+	return _nc_list_new(parent, title, h, w, y, x, color, 
+			value, size, box, shadow, sizeof(NcList));
+}
+
+NcWidget * nc_list_new_virtual(
+		NcWin *parent,
+		const char *title,
+		int h, int w, int y, int x,
+		int color,
+		int size,
+		NcListFill fill,
+		void *userdata,
+		bool box,
+		bool shadow
+		)
+{
+	NcList *nclist = (NcList *)_nc_list_new(parent, title, h, w, y, x, 
+			color, NULL, 0, box, shadow, sizeof(NcList));
+	if (!nclist)
+		return NULL;
+	nc_list_set_source(nclist, size, fill, userdata);
+	return (NcWidget*)nclist;
+}
@@ -0,0 +1,206 @@
+/**
+ * File              : ncpaint.c
+ * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
+ * Date              : 17.10.2026
+ * Last Modified Date: 17.10.2026
+ * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
+ */
+
+#include "ncwidgets.h"
+#include "struct.h"
+#include "utils.h"
+#include <curses.h>
+#include <pthread.h>
+
+/* interned attributes: chars keep index in table instead of
+ * attr_t. Table is append only, so index of attr never
+ * changes */
+attr_t _nc_attrs[U8CHAR_ATTRS] = {A_NORMAL};
+
+static struct {
+	int count;
+	unsigned short slots[U8CHAR_ATTRS * 2]; // index + 1
+	pthread_mutex_t lock;
+} attrs = {1, {0}, PTHREAD_MUTEX_INITIALIZER};
+
+int _nc_attr_intern(attr_t attr)
+{
+	if (attr == A_NORMAL)
+		return 0;
+
+	int index = 0;
+	unsigned int i = ((unsigned int)attr * 2654435761u) >> 20;
+	pthread_mutex_lock(&attrs.lock);
+	for (;; ++i) {
+		unsigned short *slot = &attrs.slots[i % (U8CHAR_ATTRS * 2)];
+		if (!*slot){
+			// table is full - attribute can not be packed
+			if (attrs.count == U8CHAR_ATTRS){
+				index = -1;
+				break;
+			}
+			_nc_attrs[attrs.count] = attr;
+			*slot = ++attrs.count;
+		}
+		if (_nc_attrs[*slot - 1] == attr){
+			index = *slot - 1;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&attrs.lock);
+	return index;
+}
+
+/* output buffer of run - chars with the same attributes
+ * are written with one attribute change and one string
+ * write */
+struct run {
+	WINDOW *win;
+	attr_t attr;
+	int len;
+	char buf[256];
+};
+
+static void _nc_run_flush(struct run *r)
+{
+	if (!r->len)
+		return;
+	wattrset(r->win, r->attr);
+	waddnstr(r->win, r->buf, r->len);
+	r->len = 0;
+}
+
+static void _nc_run_add(struct run *r, uint32_t cp, attr_t attr)
+{
+	if (attr != r->attr || r->len + 4 > (int)sizeof(r->buf)){
+		_nc_run_flush(r);
+		r->attr = attr;
+	}
+	r->len += utf8_encode(cp, &r->buf[r->len]);
+}
+
+/* pad row end from column col with blanks, first blank is
+ * reversed if cursor is after text */
+static void _nc_run_pad(
+		struct run *r, int col, int width, attr_t fill, bool cursor)
+{
+	for (; col < width; ++col, cursor = false)
+		_nc_run_add(r, ' ', fill | (cursor ? A_REVERSE : 0));
+
+	_nc_run_flush(r);
+	wattrset(r->win, A_NORMAL);
+}
+
+int _nc_paint_row(
+		WINDOW *win, int y, int x, int width,
+		const u8char_t *str, int len,
+		attr_t attr, attr_t fill, int cursor)
+{
+	struct run r;
+	r.win = win;
+	r.attr = 0;
+	r.len = 0;
+	int i = 0, col = 0;
+	wmove(win, y, x);
+
+	// write content - wide chars take two columns
+	for (; str && (len < 0 || i < len) && u8char_cp(str[i]); ++i) {
+		int cw = utf8_width(u8char_cp(str[i]));
+		if (col + cw > width)
+			break;
+		col += cw;
+		attr_t a = u8char_attr(str[i]) | attr;
+		if (i == cursor)
+			a |= A_REVERSE;
+		switch (u8char_cp(str[i])) {
+			case '\n': case '\r': case '\t':
+				_nc_run_add(&r, ' ', a);
+				break;
+			default:
+				_nc_run_add(&r, u8char_cp(str[i]), a);
+				break;
+		}
+	}
+
+	_nc_run_pad(&r, col, width, fill, i == cursor);
+	return i;
+}
+
+int _nc_paint_text(
+		WINDOW *win, int y, int x, int width,
+		NcTextIter *it, int len,
+		attr_t attr, attr_t fill, int cursor)
+{
+	struct run r;
+	r.win = win;
+	r.attr = 0;
+	r.len = 0;
+	int i = 0, col = 0;
+	wmove(win, y, x);
+
+	// run of plain chars in text bytes
+	const char *bytes = it ? nc_text_bytes(it->text) : NULL;
+	size_t start = 0, end = 0;
+	attr_t rattr = 0;
+
+	for (; it && (len < 0 || i < len); ++i) {
+		uint32_t cp;
+		attr_t a;
+		NcTextIter prev = *it;
+		if (!nc_text_next(it, &cp, &a))
+			break;
+
+		// wide char is not cut at end of row
+		int cw = utf8_width(cp);
+		if (col + cw > width){
+			*it = prev;
+			break;
+		}
+		col += cw;
+		size_t pos = prev.pos;
+		a |= attr;
+
+		bool plain = cp != '\n' && cp != '\r' && cp != '\t' && i != cursor;
+		if (end > start && (!plain || a != rattr)){
+			wattrset(win, rattr);
+			waddnstr(win, &bytes[start], end - start);
+			start = end;
+		}
+		if (plain){
+			if (end == start){
+				start = pos;
+				rattr = a;
+			}
+			end = it->pos;
+			continue;
+		}
+
+		// control chars are blanks, cursor is reversed
+		if (i == cursor)
+			a |= A_REVERSE;
+		_nc_run_add(&r, cp < ' ' ? ' ' : cp, a);
+		_nc_run_flush(&r);
+	}
+	if (end > start){
+		wattrset(win, rattr);
+		waddnstr(win, &bytes[start], end - start);
+	}
+
+	_nc_run_pad(&r, col, width, fill, i == cursor);
+	return i;
+}
+
+int _nc_cells_put(
+		u8char_t *cells, int pos, int max,
+		const char *str, attr_t attr)
+{
+	int index = _nc_attr_intern(attr);
+	if (index < 0)
+		return -1;
+	while (*str && pos < max){
+		uint32_t cp;
+		str += utf8_decode(str, &cp);
+		cells[pos++] = u8char_pack(cp, index);
+	}
+	return pos;
+}
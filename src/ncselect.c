@@ -2,7 +2,7 @@
  * File              : ncselect.c
  * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
  * Date              : 08.05.2024
- * Last Modified Date: 10.05.2024
+ * Last Modified Date: 17.10.2026
  * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
  */
 #include "colors.h"
@@ -44,10 +44,7 @@ void nc_selection_set_value(NcSelection *s, int size, char **value)
 {
 	int i;
 
-	// free old info
-	for (i = 0; i < s->nclist.size; ++i)
-		free(s->nclist.info[i]);
-	free(s->nclist.info);
+	_nc_list_clear(&s->nclist);
 
 	// allocate new info
 	s->nclist.info = malloc( 8 * size + 8);
@@ -76,12 +73,13 @@ void nc_selection_set_value(NcSelection *s, int size, char **value)
 		strcpy(str, s->selections[s->selected[i]]);
 		strcat(str, value[i]);
 	
-		s->nclist.info[i] = str2ucharstr(str, s->nclist.ncwidget.ncwin.color);
+		s->nclist.info[i] = nc_text_new(str, s->nclist.ncwidget.ncwin.color);
 
 		free(str);
 	}
 
-	nc_widget_refresh((NcWidget*)s);
+	_nc_list_mark_all(&s->nclist);
+	nc_widget_invalidate((NcWidget*)s);
 
 	// free old values
 	/*
@@ -215,12 +213,8 @@ nc_selection_new(
 		)
 {
 	NcSelection *s = 
-		(NcSelection *)nc_list_new(parent, title, h, w, y, x, color, NULL, 0, box, shadow);
-	if (!s)
-		return NULL;
-
-	// realloc 
-	s = realloc(s, sizeof(NcSelection));
+		(NcSelection *)_nc_list_new(parent, title, h, w, y, x, color, 
+				NULL, 0, box, shadow, sizeof(NcSelection));
 	if (!s)
 		return NULL;
 	
@@ -0,0 +1,237 @@
+/**
+ * File              : ncstats.c
+ * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
+ * Date              : 17.10.2026
+ * Last Modified Date: 17.10.2026
+ * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
+ */
+
+#include "ncwidgets.h"
+#include "struct.h"
+#include <curses.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/* curses output goes to socket with packets, so every write
+ * of curses is one packet. Reader thread counts packets and
+ * bytes and forwards them to terminal. After flush of frame
+ * sync packet is sent to know when reader got all output of
+ * frame */
+
+#define NC_STATS_SYNC    "\0NCSYNC"
+#define NC_STATS_RING    64
+
+static struct {
+	int fd;              // write end - output of curses
+	int rfd;             // read end
+	int target;          // terminal file descriptor
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	unsigned long synced;
+	unsigned long requested;
+
+	NcStats total;       // all output
+	NcStats mark;        // total at start of frame
+	NcStats frame;       // last frame output
+	unsigned long id;    // number of current frame
+	unsigned long cells; // cells staged in current frame
+
+	// last frames to share output between widgets
+	struct {
+		unsigned long id, bytes, writes, cells;
+	} ring[NC_STATS_RING];
+} stats = {
+	.fd     = -1,
+	.rfd    = -1,
+	.target = -1,
+	.lock   = PTHREAD_MUTEX_INITIALIZER,
+	.cond   = PTHREAD_COND_INITIALIZER,
+	.id     = 1,     // 0 - window was never staged
+};
+
+static void *_nc_stats_reader(void *arg)
+{
+	(void)arg;
+	static char buf[0x40000];
+	ssize_t n;
+	while ((n = read(stats.rfd, buf, sizeof(buf))) > 0) {
+		pthread_mutex_lock(&stats.lock);
+		if (n == sizeof(NC_STATS_SYNC) &&
+				!memcmp(buf, NC_STATS_SYNC, n))
+		{
+			stats.synced++;
+			pthread_cond_broadcast(&stats.cond);
+			pthread_mutex_unlock(&stats.lock);
+			continue;
+		}
+		stats.total.bytes += n;
+		stats.total.writes++;
+		pthread_mutex_unlock(&stats.lock);
+
+		// forward to terminal
+		ssize_t i = 0;
+		while (stats.target >= 0 && i < n){
+			ssize_t ret = write(stats.target, &buf[i], n - i);
+			if (ret <= 0)
+				break;
+			i += ret;
+		}
+	}
+	return NULL;
+}
+
+FILE *_nc_stats_open(int target)
+{
+	int fds[2];
+	if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, fds))
+		return NULL;
+
+	FILE *fp = fdopen(fds[0], "w");
+	if (!fp){
+		close(fds[0]);
+		close(fds[1]);
+		return NULL;
+	}
+
+	stats.fd     = fds[0];
+	stats.rfd    = fds[1];
+	stats.target = target;
+	stats.synced = stats.requested = 0;
+	if (pthread_create(&stats.thread, NULL, _nc_stats_reader, NULL)){
+		fclose(fp);
+		close(fds[1]);
+		stats.fd = stats.rfd = -1;
+		return NULL;
+	}
+
+	return fp;
+}
+
+/* wait until reader got all written output */
+static void _nc_stats_sync()
+{
+	if (stats.fd < 0)
+		return;
+
+	if (write(stats.fd, NC_STATS_SYNC, sizeof(NC_STATS_SYNC)) < 0)
+		return;
+
+	pthread_mutex_lock(&stats.lock);
+	stats.requested++;
+	while (stats.synced < stats.requested)
+		pthread_cond_wait(&stats.cond, &stats.lock);
+	pthread_mutex_unlock(&stats.lock);
+}
+
+void _nc_stats_close(FILE *fp)
+{
+	if (stats.fd < 0)
+		return;
+
+	_nc_stats_sync();
+
+	// reader stops at end of file
+	fclose(fp);
+	pthread_join(stats.thread, NULL);
+	close(stats.rfd);
+	stats.fd = stats.rfd = stats.target = -1;
+}
+
+/* add share of frames output to window stats */
+static void _nc_stats_settle(NcWin *ncwin)
+{
+	if (!ncwin->stats_cells || ncwin->stats_frame >= stats.id)
+		return;
+
+	int i = ncwin->stats_frame % NC_STATS_RING;
+	if (stats.ring[i].id == ncwin->stats_frame && stats.ring[i].cells){
+		ncwin->stats.bytes  +=
+			stats.ring[i].bytes * ncwin->stats_cells / stats.ring[i].cells;
+		ncwin->stats.writes +=
+			(stats.ring[i].writes * ncwin->stats_cells +
+			 stats.ring[i].cells / 2) / stats.ring[i].cells;
+	}
+	ncwin->stats_cells = 0;
+}
+
+void _nc_stats_stage(NcWin *ncwin)
+{
+	_nc_stats_settle(ncwin);
+
+	// count changed cells by touched lines
+	int y, h, w, n = 0;
+	getmaxyx(ncwin->overlay, h, w);
+	for (y = 0; y < h; ++y)
+		if (is_linetouched(ncwin->overlay, y))
+			n += w;
+
+	// window staged again in the same frame - count only
+	// cells over already counted
+	if (ncwin->stats_frame == stats.id){
+		if (n <= (int)ncwin->stats_cells)
+			return;
+		n -= ncwin->stats_cells;
+	} else
+		ncwin->stats.frames++;
+
+	ncwin->stats.cells += n;
+	ncwin->stats_cells += n;
+	ncwin->stats_frame  = stats.id;
+	stats.cells += n;
+}
+
+void _nc_stats_flush()
+{
+	_nc_stats_sync();
+
+	pthread_mutex_lock(&stats.lock);
+	stats.frame.bytes  = stats.total.bytes  - stats.mark.bytes;
+	stats.frame.writes = stats.total.writes - stats.mark.writes;
+	pthread_mutex_unlock(&stats.lock);
+	stats.frame.frames = 1;
+	stats.frame.cells  = stats.cells;
+
+	stats.total.frames++;
+	stats.total.cells += stats.cells;
+
+	int i = stats.id % NC_STATS_RING;
+	stats.ring[i].id     = stats.id;
+	stats.ring[i].bytes  = stats.frame.bytes;
+	stats.ring[i].writes = stats.frame.writes;
+	stats.ring[i].cells  = stats.cells;
+
+	stats.mark  = stats.total;
+	stats.cells = 0;
+	stats.id++;
+}
+
+void nc_stats_get(NcStats *out)
+{
+	pthread_mutex_lock(&stats.lock);
+	*out = stats.total;
+	pthread_mutex_unlock(&stats.lock);
+}
+
+void nc_stats_frame(NcStats *out)
+{
+	*out = stats.frame;
+}
+
+void nc_stats_reset()
+{
+	pthread_mutex_lock(&stats.lock);
+	memset(&stats.total, 0, sizeof(NcStats));
+	memset(&stats.mark,  0, sizeof(NcStats));
+	memset(&stats.frame, 0, sizeof(NcStats));
+	pthread_mutex_unlock(&stats.lock);
+}
+
+void nc_widget_stats(NcWidget *widget, NcStats *out)
+{
+	_nc_stats_settle(&widget->ncwin);
+	*out = widget->ncwin.stats;
+}
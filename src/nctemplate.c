@@ -0,0 +1,250 @@
+/**
+ * File              : nctemplate.c
+ * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
+ * Date              : 17.10.2026
+ * Last Modified Date: 17.10.2026
+ * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
+ */
+
+#include "ncwidgets.h"
+#include "struct.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* markup is parsed once to pieces - literal text with
+ * attribute and placeholders. Render only measures and
+ * copies values */
+
+static NcPiece *_nc_template_piece(
+		NcTemplate *tpl, int slot, attr_t attr, uint32_t offset)
+{
+	NcPiece *p = &tpl->pieces[tpl->npieces++];
+	p->slot   = slot;
+	p->attr   = attr;
+	p->offset = offset;
+	p->len    = 0;
+	p->chars  = 0;
+	p->cols   = 0;
+	return p;
+}
+
+NcTemplate *nc_template_new(const char *markup, int color)
+{
+	size_t size = strlen(markup), i;
+
+	// every tag and placeholder may end piece
+	int count = 1;
+	for (i = 0; i < size; ++i)
+		if (markup[i] == '<' || markup[i] == '%')
+			count += 2;
+
+	NcTemplate *tpl = malloc(sizeof(NcTemplate));
+	if (!tpl)
+		return NULL;
+	tpl->npieces = 0;
+	tpl->slots   = 0;
+	tpl->pieces  = malloc(count * sizeof(NcPiece));
+	// invalid bytes are replaced with 3 bytes of U+FFFD
+	tpl->bytes   = malloc(size * 3 + 1);
+	if (!tpl->pieces || !tpl->bytes){
+		nc_template_free(tpl);
+		return NULL;
+	}
+
+	attr_t attr = A_NORMAL|COLOR_PAIR(color);
+	uint32_t len = 0;
+	NcPiece *p = _nc_template_piece(tpl, -1, attr, len);
+
+	for (i = 0; i < size;) {
+		if (_nc_markup_is_tag(&markup[i])){
+			i += _nc_markup_tag(&markup[i], &attr, color);
+			if (p->attr == attr)
+				continue;
+			if (p->len)
+				p = _nc_template_piece(tpl, -1, attr, len);
+			else
+				p->attr = attr;
+			continue;
+		}
+
+		if (markup[i] == '%' && markup[i+1] == 's'){
+			i += 2;
+			if (!p->len)
+				tpl->npieces--;
+			_nc_template_piece(tpl, tpl->slots++, attr, len);
+			p = _nc_template_piece(tpl, -1, attr, len);
+			continue;
+		}
+
+		if (markup[i] == '%' && markup[i+1] == '%')
+			i++;
+
+		uint32_t cp;
+		int k = utf8_decode(&markup[i], &cp);
+		if (cp == U8CHAR_INVALID)
+			len += utf8_encode(cp, &tpl->bytes[len]);
+		else {
+			memcpy(&tpl->bytes[len], &markup[i], k);
+			len += k;
+		}
+		i += k;
+		p->len    = len - p->offset;
+		p->chars += 1;
+		p->cols  += utf8_width(cp);
+	}
+	if (!p->len && tpl->npieces > 1)
+		tpl->npieces--;
+	tpl->bytes[len] = 0;
+
+	return tpl;
+}
+
+void nc_template_free(NcTemplate *tpl)
+{
+	if (!tpl)
+		return;
+	free(tpl->pieces);
+	free(tpl->bytes);
+	free(tpl);
+}
+
+int nc_template_slots(const NcTemplate *tpl)
+{
+	return tpl->slots;
+}
+
+/* size of value in text */
+struct measure {
+	size_t len;       // bytes of value
+	size_t out;       // bytes in text - invalid bytes are replaced
+	uint32_t chars;
+	uint32_t cols;
+	bool valid;
+};
+
+static void _nc_template_measure(const char *s, struct measure *m)
+{
+	size_t i = 0;
+	m->len   = strlen(s);
+	m->out   = 0;
+	m->chars = 0;
+	m->cols  = 0;
+	m->valid = true;
+	while (i < m->len) {
+		size_t run = utf8_ascii_run(&s[i], m->len - i, 0);
+		if (run){
+			i        += run;
+			m->out   += run;
+			m->chars += run;
+			m->cols  += run;
+			continue;
+		}
+		uint32_t cp;
+		int k = utf8_decode(&s[i], &cp);
+		i += k;
+		m->chars++;
+		m->cols += utf8_width(cp);
+		if (cp == U8CHAR_INVALID){
+			m->out += 3;
+			m->valid = false;
+		} else
+			m->out += k;
+	}
+}
+
+NcText *nc_template_render(
+		const NcTemplate *tpl, NcText *text, const char *values[])
+{
+	struct measure m[tpl->slots > 0 ? tpl->slots : 1];
+	int i;
+	for (i = 0; i < tpl->slots; ++i)
+		_nc_template_measure(values[i] ? values[i] : "", &m[i]);
+
+	// count bytes and spans of text
+	uint32_t nspans = 0, len = 0, chars = 0, cols = 0;
+	attr_t attr = tpl->pieces[0].attr;
+	for (i = 0; i < tpl->npieces; ++i) {
+		const NcPiece *p = &tpl->pieces[i];
+		size_t n = p->slot < 0 ? p->len : m[p->slot].out;
+		if (!n)
+			continue;
+		if (!nspans || p->attr != attr){
+			attr = p->attr;
+			nspans++;
+		}
+		len   += n;
+		chars += p->slot < 0 ? p->chars : m[p->slot].chars;
+		cols  += p->slot < 0 ? p->cols  : m[p->slot].cols;
+	}
+	if (!nspans)
+		nspans = 1;
+
+	// reuse memory of text, interned text is shared - make 
+	// new one
+	NcText *shared = text && text->refs ? text : NULL;
+	if (shared)
+		text = NULL;
+	size_t need = nspans * sizeof(NcSpan) + len + 1;
+	size_t have = text ? text->nspans * sizeof(NcSpan) + text->allocated : 0;
+	if (need > have){
+		NcText *ptr = realloc(text, sizeof(NcText) + need);
+		if (!ptr)
+			return NULL;
+		if (!text){
+			ptr->index = NULL;
+			ptr->refs  = 0;
+			ptr->next  = NULL;
+		}
+		text = ptr;
+		have = need;
+	}
+	nc_text_free(shared);
+	free(text->index);
+	text->index     = NULL;
+	text->nspans    = nspans;
+	text->allocated = have - nspans * sizeof(NcSpan);
+	text->len       = len;
+	text->chars     = chars;
+	text->cols      = cols;
+
+	char *bytes = _nc_text_bytes(text);
+	uint32_t n = 0, pos = 0;
+	text->spans[0].offset = 0;
+	text->spans[0].attr   = tpl->pieces[0].attr;
+	for (i = 0; i < tpl->npieces; ++i) {
+		const NcPiece *p = &tpl->pieces[i];
+		size_t size = p->slot < 0 ? p->len : m[p->slot].out;
+		if (!size)
+			continue;
+		if (!n || p->attr != text->spans[n-1].attr){
+			text->spans[n].offset = pos;
+			text->spans[n++].attr = p->attr;
+		}
+
+		if (p->slot < 0)
+			memcpy(&bytes[pos], &tpl->bytes[p->offset], p->len);
+		else if (m[p->slot].valid)
+			memcpy(&bytes[pos], values[p->slot], size);
+		else {
+			// replace invalid bytes of value
+			const char *s = values[p->slot];
+			size_t k = 0, o = pos;
+			while (k < m[p->slot].len) {
+				uint32_t cp;
+				int l = utf8_decode(&s[k], &cp);
+				if (cp == U8CHAR_INVALID)
+					o += utf8_encode(cp, &bytes[o]);
+				else {
+					memcpy(&bytes[o], &s[k], l);
+					o += l;
+				}
+				k += l;
+			}
+		}
+		pos += size;
+	}
+	bytes[pos] = 0;
+
+	return text;
+}
@@ -0,0 +1,480 @@
+/**
+ * File              : nctext.c
+ * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
+ * Date              : 17.10.2026
+ * Last Modified Date: 17.10.2026
+ * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
+ */
+
+#include "ncwidgets.h"
+#include "struct.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+NcText *nc_text_new(const char *markup, int color)
+{
+	size_t size = strlen(markup), i;
+
+	// every tag may start span
+	uint32_t nspans = 1;
+	const char *tag = markup;
+	while ((tag = memchr(tag, '<', size - (tag - markup)))){
+		if (_nc_markup_is_tag(tag))
+			nspans++;
+		tag++;
+	}
+
+	size_t allocated = size + 1;
+	NcText *text =
+		malloc(sizeof(NcText) + nspans * sizeof(NcSpan) + allocated);
+	if (!text)
+		return NULL;
+	text->nspans = nspans;
+
+	char *bytes = _nc_text_bytes(text);
+	attr_t attr = A_NORMAL|COLOR_PAIR(color);
+	uint32_t n = 0, len = 0, chars = 0, cols = 0;
+	text->spans[n].offset = 0;
+	text->spans[n++].attr = attr;
+
+	for (i = 0; i < size;) {
+		unsigned char c = markup[i];
+		if (c < 0x80){
+			if (_nc_markup_is_tag(&markup[i])){
+				i += _nc_markup_tag(&markup[i], &attr, color);
+
+				// change attribute of empty span or start new one
+				if (text->spans[n-1].offset == len){
+					text->spans[n-1].attr = attr;
+					if (n > 1 && text->spans[n-2].attr == attr)
+						n--;
+				} else if (text->spans[n-1].attr != attr){
+					text->spans[n].offset = len;
+					text->spans[n++].attr = attr;
+				}
+				continue;
+			}
+
+			// ascii chars up to next tag are copied as is
+			size_t run = utf8_ascii_run(&markup[i + 1], size - i - 1, '<') + 1;
+			memcpy(&bytes[len], &markup[i], run);
+			len += run;
+			chars += run;
+			cols  += run;
+			i += run;
+			continue;
+		}
+
+		uint32_t cp;
+		int k = utf8_decode(&markup[i], &cp);
+		i += k;
+		chars++;
+		cols += utf8_width(cp);
+		if (cp != U8CHAR_INVALID){
+			memcpy(&bytes[len], &markup[i - k], k);
+			len += k;
+			continue;
+		}
+
+		// text keeps valid utf8 only - invalid bytes are 
+		// replaced with U+FFFD which may be longer
+		if (len + 3 + size - i + 1 > allocated){
+			size_t need = len + 3 + size - i + 1;
+			allocated = need > allocated * 2 ? need : allocated * 2;
+			NcText *ptr = realloc(text,
+					sizeof(NcText) + nspans * sizeof(NcSpan) + allocated);
+			if (!ptr){
+				free(text);
+				return NULL;
+			}
+			text = ptr;
+			bytes = _nc_text_bytes(text);
+		}
+		len += utf8_encode(cp, &bytes[len]);
+	}
+	bytes[len] = 0;
+
+	// move bytes to end of used spans
+	if (n < nspans){
+		memmove(&text->spans[n], bytes, len + 1);
+		text->nspans = n;
+	}
+	text->len = len;
+	text->chars = chars;
+	text->cols  = cols;
+	text->index = NULL;
+	text->refs  = 0;
+	text->hash  = 0;
+	text->next  = NULL;
+	text->allocated = allocated + (nspans - n) * sizeof(NcSpan);
+
+	return text;
+}
+
+void nc_text_free(NcText *text)
+{
+	if (!text)
+		return;
+	if (text->refs){
+		_nc_text_release(text);
+		return;
+	}
+	free(text->index);
+	free(text);
+}
+
+/* ascii text has char index equal to byte offset and column */
+static bool _nc_text_ascii(const NcText *text)
+{
+	return text->len == text->chars;
+}
+
+/* index of marks for not ascii text. Shared texts are read
+ * by several threads, so index is published with compare and
+ * swap and index of thread which lost is dropped */
+static NcTextIndex *_nc_text_index(const NcText *text)
+{
+	NcTextIndex *index = __atomic_load_n(&text->index, __ATOMIC_ACQUIRE);
+	if (index)
+		return index;
+
+	uint32_t count = text->chars / NC_TEXT_STEP + 1;
+	index = malloc(
+			sizeof(NcTextIndex) + count * sizeof(index->marks[0]));
+	if (!index)
+		return NULL;
+	index->count = count;
+
+	const char *bytes = _nc_text_bytes(text);
+	uint32_t i, pos = 0, col = 0;
+	for (i = 0; i < text->chars; ++i) {
+		if (i % NC_TEXT_STEP == 0){
+			index->marks[i / NC_TEXT_STEP].pos = pos;
+			index->marks[i / NC_TEXT_STEP].col = col;
+		}
+		uint32_t cp;
+		pos += utf8_decode(&bytes[pos], &cp);
+		col += utf8_width(cp);
+	}
+	if (i % NC_TEXT_STEP == 0){
+		index->marks[i / NC_TEXT_STEP].pos = pos;
+		index->marks[i / NC_TEXT_STEP].col = col;
+	}
+
+	// index is cache - text is not changed
+	NcTextIndex *expected = NULL;
+	if (!__atomic_compare_exchange_n(&((NcText *)text)->index,
+				&expected, index, false,
+				__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+	{
+		free(index);
+		return expected;
+	}
+	return index;
+}
+
+/* drop cached index after change of text */
+static void _nc_text_changed(NcText *text)
+{
+	free(text->index);
+	text->index = NULL;
+}
+
+size_t nc_text_cols(const NcText *text)
+{
+	return text->cols;
+}
+
+size_t nc_text_col(const NcText *text, size_t index)
+{
+	if (index >= text->chars)
+		return text->cols;
+	if (_nc_text_ascii(text))
+		return index;
+
+	NcTextIndex *ti = _nc_text_index(text);
+	if (!ti){
+		// no memory for index - count from start
+		NcTextIter it;
+		uint32_t cp;
+		attr_t attr;
+		size_t col = 0;
+		nc_text_iter(&it, text, 0);
+		while (it.index < index && nc_text_next(&it, &cp, &attr))
+			col += utf8_width(cp);
+		return col;
+	}
+
+	const char *bytes = _nc_text_bytes(text);
+	size_t i = index / NC_TEXT_STEP * NC_TEXT_STEP;
+	size_t pos = ti->marks[index / NC_TEXT_STEP].pos;
+	size_t col = ti->marks[index / NC_TEXT_STEP].col;
+	for (; i < index; ++i) {
+		uint32_t cp;
+		pos += utf8_decode(&bytes[pos], &cp);
+		col += utf8_width(cp);
+	}
+	return col;
+}
+
+size_t nc_text_index_at(const NcText *text, size_t col)
+{
+	if (col >= text->cols)
+		return text->chars;
+	if (_nc_text_ascii(text))
+		return col;
+
+	size_t i = 0, pos = 0, c = 0;
+	NcTextIndex *ti = _nc_text_index(text);
+	if (ti){
+		// last mark before column
+		uint32_t lo = 0, hi = ti->count;
+		while (hi - lo > 1) {
+			uint32_t mid = (lo + hi) / 2;
+			if (ti->marks[mid].col <= col)
+				lo = mid;
+			else
+				hi = mid;
+		}
+		i   = lo * NC_TEXT_STEP;
+		pos = ti->marks[lo].pos;
+		c   = ti->marks[lo].col;
+	}
+
+	const char *bytes = _nc_text_bytes(text);
+	for (; i < text->chars; ++i) {
+		uint32_t cp;
+		pos += utf8_decode(&bytes[pos], &cp);
+		c += utf8_width(cp);
+		if (c > col)
+			break;
+	}
+	return i;
+}
+
+const char *nc_text_bytes(const NcText *text)
+{
+	return _nc_text_bytes(text);
+}
+
+size_t nc_text_len(const NcText *text)
+{
+	return text->len;
+}
+
+size_t nc_text_chars(const NcText *text)
+{
+	return text->chars;
+}
+
+char *nc_text_str(const NcText *text)
+{
+	char *str = malloc(text->len + 1);
+	if (!str)
+		return NULL;
+	memcpy(str, _nc_text_bytes(text), text->len + 1);
+	return str;
+}
+
+void nc_text_iter(NcTextIter *it, const NcText *text, size_t index)
+{
+	it->text  = text;
+	it->pos   = 0;
+	it->index = 0;
+	it->span  = 0;
+
+	if (text->chars == text->len){
+		// ascii text - char index is byte offset
+		it->pos = it->index = index < text->len ? index : text->len;
+	} else {
+		const char *bytes = _nc_text_bytes(text);
+		uint32_t cp;
+		NcTextIndex *ti = 
+			index >= NC_TEXT_STEP ? _nc_text_index(text) : NULL;
+		if (ti){
+			size_t mark = index < text->chars ? 
+				index / NC_TEXT_STEP : text->chars / NC_TEXT_STEP;
+			it->index = mark * NC_TEXT_STEP;
+			it->pos   = ti->marks[mark].pos;
+		}
+		while (it->index < index && it->pos < text->len){
+			it->pos += utf8_decode(&bytes[it->pos], &cp);
+			it->index++;
+		}
+	}
+
+	// find last span started before position
+	uint32_t lo = 0, hi = text->nspans;
+	while (hi - lo > 1) {
+		uint32_t mid = (lo + hi) / 2;
+		if (text->spans[mid].offset <= it->pos)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	it->span = lo;
+}
+
+bool nc_text_next(NcTextIter *it, uint32_t *cp, attr_t *attr)
+{
+	const NcText *text = it->text;
+	if (it->pos >= text->len)
+		return false;
+
+	while (it->span + 1 < text->nspans &&
+			text->spans[it->span + 1].offset <= it->pos)
+		it->span++;
+
+	*attr = text->spans[it->span].attr;
+	it->pos += utf8_decode(&_nc_text_bytes(text)[it->pos], cp);
+	it->index++;
+	return true;
+}
+
+/* decode char of not more than len bytes */
+static int _nc_text_decode(const char *utf8, size_t len, uint32_t *cp)
+{
+	if (len >= 4)
+		return utf8_decode(utf8, cp);
+	char buf[4] = {0};
+	memcpy(buf, utf8, len);
+	return utf8_decode(buf, cp);
+}
+
+NcText *nc_text_insert(
+		NcText *text, size_t index, const char *utf8, size_t len)
+{
+	// text keeps valid utf8 only - invalid bytes are replaced
+	// with U+FFFD which may be longer
+	size_t i, size = 0, chars = 0, cols = 0;
+	uint32_t cp;
+	for (i = 0; i < len; chars++){
+		int k = _nc_text_decode(&utf8[i], len - i, &cp);
+		i += k;
+		size += cp == U8CHAR_INVALID ? 3 : k;
+		cols += utf8_width(cp);
+	}
+
+	// grow text twice to insert chars by one
+	if (text->len + size + 1 > text->allocated){
+		size_t allocated = text->allocated * 2;
+		if (allocated < text->len + size + 1)
+			allocated = text->len + size + 1;
+		NcText *ptr = realloc(text,
+				sizeof(NcText) + text->nspans * sizeof(NcSpan) + allocated);
+		if (!ptr)
+			return NULL;
+		text = ptr;
+		text->allocated = allocated;
+	}
+
+	NcTextIter it;
+	nc_text_iter(&it, text, index);
+	char *bytes = _nc_text_bytes(text);
+	memmove(&bytes[it.pos + size], &bytes[it.pos], text->len - it.pos + 1);
+	if (size == len)
+		memcpy(&bytes[it.pos], utf8, len);
+	else {
+		char *out = &bytes[it.pos];
+		for (i = 0; i < len;){
+			int k = _nc_text_decode(&utf8[i], len - i, &cp);
+			if (cp == U8CHAR_INVALID)
+				out += utf8_encode(cp, out);
+			else {
+				memcpy(out, &utf8[i], k);
+				out += k;
+			}
+			i += k;
+		}
+	}
+
+	text->len   += size;
+	text->chars += chars;
+	text->cols  += cols;
+	_nc_text_changed(text);
+
+	// inserted chars get attribute of previous char
+	for (i = 1; i < text->nspans; ++i)
+		if (text->spans[i].offset >= it.pos)
+			text->spans[i].offset += size;
+
+	return text;
+}
+
+void nc_text_remove(NcText *text, size_t index, size_t count)
+{
+	NcTextIter it;
+	nc_text_iter(&it, text, index);
+	size_t start = it.pos;
+
+	uint32_t cp;
+	attr_t attr;
+	while (count-- && nc_text_next(&it, &cp, &attr)){
+		text->chars--;
+		text->cols -= utf8_width(cp);
+	}
+	_nc_text_changed(text);
+	size_t end = it.pos;
+
+	char *bytes = _nc_text_bytes(text);
+	memmove(&bytes[start], &bytes[end], text->len - end + 1);
+	text->len -= end - start;
+
+	size_t i;
+	for (i = 1; i < text->nspans; ++i) {
+		if (text->spans[i].offset > end)
+			text->spans[i].offset -= end - start;
+		else if (text->spans[i].offset > start)
+			text->spans[i].offset = start;
+	}
+}
+
+NcText *_nc_text_mark(
+		const NcText *text, const uint32_t *pos, size_t npos, attr_t attr)
+{
+	uint32_t nspans = text->nspans + 2 * npos;
+	NcText *mark = malloc(
+			sizeof(NcText) + nspans * sizeof(NcSpan) + text->len + 1);
+	if (!mark)
+		return NULL;
+
+	// merge spans of text with marked bytes
+	uint32_t n = 0, s = 0, off = 0;
+	size_t k = 0;
+	attr_t base = text->spans[0].attr;
+	for (;;) {
+		bool marked = k < npos && pos[k] == off;
+		attr_t a = marked ? base | attr : base;
+		if (!n || mark->spans[n-1].attr != a){
+			mark->spans[n].offset = off;
+			mark->spans[n++].attr = a;
+		}
+
+		// marked char is one span with all its bytes
+		uint32_t cp, next = marked ?
+			off + utf8_decode(&_nc_text_bytes(text)[off], &cp) :
+			k < npos ? pos[k] : text->len;
+		if (s + 1 < text->nspans && text->spans[s + 1].offset < next)
+			next = text->spans[s + 1].offset;
+		if (next >= text->len)
+			break;
+		off = next;
+		if (marked)
+			k++;
+		while (s + 1 < text->nspans && text->spans[s + 1].offset <= off)
+			base = text->spans[++s].attr;
+	}
+	mark->nspans = n;
+	memcpy(_nc_text_bytes(mark), _nc_text_bytes(text), text->len + 1);
+
+	mark->len   = text->len;
+	mark->chars = text->chars;
+	mark->cols  = text->cols;
+	mark->index = NULL;
+	mark->refs  = 0;
+	mark->hash  = 0;
+	mark->next  = NULL;
+	mark->allocated = text->len + 1 + (nspans - n) * sizeof(NcSpan);
+	return mark;
+}
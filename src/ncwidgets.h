@@ -2,7 +2,7 @@
  * File              : ncwidgets.h
  * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
  * Date              : 12.06.2023
- * Last Modified Date: 09.05.2024
+ * Last Modified Date: 17.10.2026
  * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
  */
 
@@ -16,12 +16,187 @@
 
 #include "colors.h"
 
-/* init curses */
+/* init curses, output is not counted - see nc_init_stats() */
 void nc_init(const char *locale, int color);
 
+/* init curses on terminal of stdout and count its output.
+ * stdout is socket read by thread which forwards output to
+ * terminal until nc_quit(), stderr should be terminal too.
+ * Return 0 on success, -1 - use nc_init() */
+int nc_init_stats(const char *locale, int color);
+
+/* init curses on headless terminal: output is written to
+ * device (pty or /dev/null if NULL), input is read from pipe
+ * filled with nc_headless_feed(). term is TERM name (xterm 
+ * if NULL), lines and cols - screen size. Return 0 on success */
+int nc_init_headless(
+		const char *locale,
+		int color,
+		const char *term,
+		int lines, int cols,
+		const char *device
+		);
+
+/* feed bytes to input of headless terminal */
+int nc_headless_feed(const char *bytes, int len);
+
+/* feed key (char or KEY_ code) to input of headless terminal */
+int nc_headless_feed_key(int key);
+
+/* output statistics. Bytes and write() calls are counted on
+ * headless terminal and terminal of nc_init_stats(), after
+ * nc_init() they stay 0. Widgets get share of frame output by
+ * number of cells they changed */
+typedef struct NcStats {
+	unsigned long frames; // flushed frames or widget refreshes
+	unsigned long bytes;  // bytes written to terminal
+	unsigned long writes; // write() calls
+	unsigned long cells;  // changed cells
+} NcStats;
+
+/* statistics of all output since nc_stats_reset() */
+void nc_stats_get(NcStats *stats);
+
+/* statistics of last flushed frame */
+void nc_stats_frame(NcStats *stats);
+
+void nc_stats_reset();
+
 /* quit curses */
 void nc_quit();
 
+/* frame - widgets only stage output, terminal is flushed
+ * once per input event read with nc_getch() or by
+ * nc_frame_commit() */
+void nc_frame_commit();
+
+/* number of terminal flushes made during last frame */
+int nc_frame_flushes();
+
+/* limit frames per second committed by nc_frame_update(),
+ * 0 - no limit. Input events are always flushed at once */
+void nc_frame_set_rate(int fps);
+
+/* paint invalidated widgets and flush frame if it is time
+ * for next frame. Return true if frame was flushed */
+bool nc_frame_update();
+
+/* flush staged frame and read input char. While async 
+ * lists fetch rows, input is polled to paint arrived rows */
+int nc_getch();
+
+/* text - utf8 bytes without markup and spans of attributes.
+ * Markup is </B> bold, </U> underline, </N> color pair N, 
+ * tags with ! instead of / turn attributes off */
+typedef struct NcText NcText;
+NcText *nc_text_new(const char *markup, int color);
+void nc_text_free(NcText *text);
+/* utf8 bytes of text, zero terminated */
+const char *nc_text_bytes(const NcText *text);
+/* number of bytes */
+size_t nc_text_len(const NcText *text);
+/* number of chars */
+size_t nc_text_chars(const NcText *text);
+/* allocated copy of text bytes */
+char *nc_text_str(const NcText *text);
+/* number of terminal columns */
+size_t nc_text_cols(const NcText *text);
+/* column of char with index */
+size_t nc_text_col(const NcText *text, size_t index);
+/* index of char painted at column, number of chars if
+ * column is after text */
+size_t nc_text_index_at(const NcText *text, size_t col);
+
+/* insert utf8 chars before char index, invalid bytes are
+ * inserted as U+FFFD. Text may be moved - return new pointer
+ * or NULL on error (text is not changed) */
+NcText *nc_text_insert(
+		NcText *text, size_t index, const char *utf8, size_t len);
+/* remove count chars from char index */
+void nc_text_remove(NcText *text, size_t index, size_t count);
+
+/* interned text is shared by all users with the same 
+ * chars and attributes and freed with nc_text_free() by
+ * last of them. Interned text should not be changed */
+NcText *nc_text_intern(const char *markup, int color);
+/* intern rows of lists and labels, off by default */
+void nc_text_set_interning(bool rows);
+
+typedef struct NcInternStats {
+	unsigned long strings; // interned texts
+	unsigned long refs;    // users of them, refs/strings is dedup ratio
+	unsigned long bytes;   // memory of interned texts
+	unsigned long saved;   // memory saved by sharing
+} NcInternStats;
+void nc_text_intern_stats(NcInternStats *stats);
+
+/* decoded rows of borrowed and virtual lists are kept in
+ * one cache of all widgets. Rows over byte budget (4 MiB by
+ * default) are dropped from least recently used, rows
+ * painted in current frame are kept */
+void nc_cache_set_budget(size_t bytes);
+
+typedef struct NcCacheStats {
+	unsigned long hits;      // rows found in cache
+	unsigned long misses;    // rows decoded from source
+	unsigned long evictions; // rows dropped over budget
+	unsigned long rows;      // rows in cache
+	size_t bytes;            // memory of cached rows
+	size_t budget;
+} NcCacheStats;
+void nc_cache_stats(NcCacheStats *stats);
+
+/* template - markup compiled once with %s placeholders
+ * for values (%% is percent sign). Values are plain utf8
+ * text painted with attributes of placeholder */
+typedef struct NcTemplate NcTemplate;
+NcTemplate *nc_template_new(const char *markup, int color);
+void nc_template_free(NcTemplate *tpl);
+/* number of placeholders */
+int nc_template_slots(const NcTemplate *tpl);
+/* make text from template and values. Text is reused and 
+ * grows only if new text does not fit, new text is 
+ * allocated if text is NULL. Return text (it may be moved) 
+ * or NULL on error (text is not changed) */
+NcText *nc_template_render(
+		const NcTemplate *tpl, NcText *text, const char *values[]);
+
+/* decoder of markup stream - bytes are given by chunks of
+ * any size, char or tag cut by chunk end is kept to next 
+ * chunk. Every finished line is given to on_line (line
+ * should be freed with nc_text_free()), attributes are reset
+ * at start of line */
+typedef struct NcDecoder NcDecoder;
+NcDecoder *nc_decoder_new(int color, 
+		void (*on_line)(void *userdata, NcText *line), void *userdata);
+void nc_decoder_free(NcDecoder *decoder);
+/* decode chunk, return -1 on error */
+int nc_decoder_feed(NcDecoder *decoder, const char *bytes, size_t len);
+/* end of stream - cut char is invalid, last line without
+ * newline is given to on_line */
+int nc_decoder_finish(NcDecoder *decoder);
+/* decoded chars of unfinished line, valid until next call
+ * of decoder */
+const NcText *nc_decoder_pending(NcDecoder *decoder);
+/* decode ANSI SGR escape sequences (bold, underline, 8, 256
+ * and true colors) instead of markup. Colors are mapped to
+ * nearest of 8 colors, other escape sequences are dropped.
+ * Attributes are kept from line to line as in terminal */
+void nc_decoder_set_ansi(NcDecoder *decoder, bool ansi);
+
+/* iterator of text chars */
+typedef struct NcTextIter {
+	const NcText *text;
+	size_t pos;   // byte offset of next char
+	size_t index; // index of next char
+	unsigned span;
+} NcTextIter;
+
+/* start iterator from char index */
+void nc_text_iter(NcTextIter *it, const NcText *text, size_t index);
+/* get next char and attribute, return false at end */
+bool nc_text_next(NcTextIter *it, uint32_t *cp, attr_t *attr);
+
 /* return codes of callback */
 typedef enum NCRET {
 	NCNONE, // do nothing
@@ -65,6 +240,9 @@ void nc_win_destroy(NcWin *ncwin);
 /* widget is NcWin with controls */
 typedef struct NcWidget NcWidget;
 void nc_widget_refresh(NcWidget *widget);
+/* mark widget to repaint in next frame - any number of
+ * updates between frames is painted once */
+void nc_widget_invalidate(NcWidget *widget);
 void nc_widget_set_focused(NcWidget *widget, bool focused);
 void nc_widget_activate(
 		NcWidget *widget, 
@@ -74,6 +252,8 @@ void nc_widget_activate(
 void nc_widget_destroy(NcWidget *widget);
 int nc_widget_move(NcWidget *widget, int y, int x);
 int nc_widget_resize(NcWidget *widget, int h, int w);
+/* statistics of widget output */
+void nc_widget_stats(NcWidget *widget, NcStats *stats);
 
 /* label - NcWindget with text */
 typedef struct NcLabel NcLabel;
@@ -86,6 +266,11 @@ NcWidget * nc_label_new(
 		bool shadow
 		);
 
+/* set line of label from template and values */
+void nc_label_render(
+		NcLabel *nclabel, int line, 
+		const NcTemplate *tpl, const char *values[]);
+
 /* button - NcLable with click callback */
 typedef NcLabel NcButton;
 NcWidget *nc_button_new(
@@ -127,6 +312,13 @@ NcWidget * nc_entry_new(
 
 void nc_entry_set_value(NcEntry *ncentry, const char *value);
 char *nc_entry_get_value(NcEntry *ncentry);
+/* copy value to buf of len bytes without allocation. Value
+ * is cut at char boundary and zero terminated. Return length
+ * of full value - value is cut if it is not less than len */
+size_t nc_entry_copy_value(NcEntry *ncentry, char *buf, size_t len);
+/* value of entry without copy, valid until entry is changed.
+ * Length of value is set to len if it is not NULL */
+const char *nc_entry_get_view(NcEntry *ncentry, size_t *len);
 void nc_entry_set_position(NcEntry *ncentry, size_t position);
 size_t nc_entry_get_position(NcEntry *ncentry);
 
@@ -163,9 +355,82 @@ NcWidget * nc_list_new(
 		);
 
 void nc_list_set_value(NcList *nclist, char **value, int size);
+
+/* set rows without copy - list keeps pointer to value and
+ * decodes only visible rows. Value and its strings should
+ * not be changed or freed until list gets new value or is
+ * destroyed - set value again after change */
+void nc_list_set_borrowed(NcList *nclist, const char **value, int size);
+/* rows of virtual list are given by fill callback when they
+ * become visible - callback writes markup of row index to 
+ * buf of len bytes and returns 0 or -1 if there is no row */
+typedef int (*NcListFill)(void *userdata, int index, char *buf, size_t len);
+NcWidget * nc_list_new_virtual(
+		NcWin *parent,
+		const char *title,
+		int h, int w, int y, int x,
+		int color,
+		int size,
+		NcListFill fill,
+		void *userdata,
+		bool box,
+		bool shadow
+		);
+/* set number of rows and fill callback, visible rows are
+ * requested again */
+void nc_list_set_source(
+		NcList *nclist, int size, NcListFill fill, void *userdata);
+
+/* rows of async list are fetched by pages on worker thread -
+ * fill is called on worker thread. Rows which are not 
+ * fetched yet are painted as placeholders and repainted by
+ * nc_getch() when they arrive, pages ahead of scroll are 
+ * fetched before they are visible */
+NcWidget * nc_list_new_async(
+		NcWin *parent,
+		const char *title,
+		int h, int w, int y, int x,
+		int color,
+		int size,
+		NcListFill fill,
+		void *userdata,
+		bool box,
+		bool shadow
+		);
+/* set number of rows and fill callback of async list, 
+ * return -1 on error */
+int nc_list_set_async(
+		NcList *nclist, int size, NcListFill fill, void *userdata);
+
+/* add row to end of list, list takes text. Return -1 on
+ * error or if list has borrowed, virtual or async value */
+int nc_list_append(NcList *nclist, NcText *row);
 void nc_list_set_selected(NcList *nclist, int index);
 int nc_list_get_selected(NcList *nclist);
 
+/* show only rows with query inside (ASCII letters of any
+ * case), NULL or empty query shows all rows. Query extended
+ * from previous one searches only rows of previous result.
+ * Return number of shown rows or -1 on error (virtual or
+ * async list - their rows are not read all) */
+int nc_list_set_filter(NcList *nclist, const char *query);
+const char *nc_list_get_filter(NcList *nclist);
+/* printable keys of activated list extend filter and 
+ * backspace shortens it, off by default. Rows are decoded
+ * and indexed at once. Return -1 on error (virtual or async
+ * list) */
+int nc_list_set_filtering(NcList *nclist, bool filtering);
+/* fuzzy filter shows top rows with chars of query in the
+ * same order, best matched rows first. Matched chars are
+ * painted with attr. Top 0 turns fuzzy filter off */
+void nc_list_set_fuzzy(NcList *nclist, int top, attr_t attr);
+/* threads scoring rows of fuzzy filter with main thread, 
+ * -1 (default) - one less than number of cpus */
+void nc_fuzzy_set_threads(int threads);
+/* index of shown row in rows given to list, -1 if out of
+ * list */
+int nc_list_get_source_row(NcList *nclist, int index);
+
 /* selection list */
 typedef struct NcSelection NcSelection;
 NcWidget *nc_selection_new(
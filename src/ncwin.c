@@ -2,7 +2,7 @@
  * File              : ncwin.c
  * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
  * Date              : 12.06.2023
- * Last Modified Date: 10.05.2024
+ * Last Modified Date: 17.10.2026
  * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
  */
 
@@ -15,31 +15,274 @@
 
 void nc_win_set_title(NcWin *ncwin, const char *title)
 {
-	int i;
+	int w = getmaxx(ncwin->overlay);
 	if (ncwin->title)
-		free(ncwin->title);
+		nc_text_free(ncwin->title);
 
 	// fill with blank chars first
-	wattron (ncwin->overlay, COLOR_PAIR(ncwin->color));
-	for (i = 0; i < ncwin->overlay->_maxx-ncwin->overlay->_begx; ++i) 
-		waddch(ncwin->overlay, ' ');	
-	wattroff(ncwin->overlay, COLOR_PAIR(ncwin->color));
+	_nc_paint_row(ncwin->overlay, 0, 0, w, NULL, 0, 0, 0, -1);
 
 	// make box
 	if (ncwin->box)
 		box(ncwin->overlay, 0, 0);
 
 	// make title
-	ncwin->title = str2ucharstr(title, ncwin->color); 
-	wmove(ncwin->overlay, 0, 1);
-	i = 0;
-	while (ncwin->title[i].utf8[0]){
-		wattron (ncwin->overlay, ncwin->title[i].attr);
-		waddstr (ncwin->overlay, ncwin->title[i].utf8);	
-		wattroff(ncwin->overlay, ncwin->title[i].attr);
-		i++;
+	ncwin->title = nc_text_new(title, ncwin->color); 
+	if (ncwin->title){
+		int len = nc_text_cols(ncwin->title);
+		NcTextIter it;
+		nc_text_iter(&it, ncwin->title, 0);
+		_nc_paint_text(ncwin->overlay, 0, 1, len < w - 2 ? len : w - 2, 
+				&it, -1, 0, 0, -1);
+	}
+	
+	_nc_frame_stage(ncwin);
+}
+
+/* top level windows with shadow have this mark as panel
+ * user pointer */
+static const char nc_win_shadow_mark = 's';
+
+/* shadow is drawn right and below window: 2 columns right
+ * of window and row under it shifted by 2 columns. Call func
+ * for every row segment of shadow in screen coordinates */
+#define nc_win_shadow_iterate(by, bx, h, w, row, col, len) \
+	for (row = by + 1; row <= by + h; ++row)\
+		if ((col = row < by + h ? bx + w : bx + 2),\
+				(len = row < by + h ? 2 : w), 1)
+
+/* change attributes of shadow area in window without
+ * changing chars */
+static void _nc_win_paint_shadow(
+		WINDOW *win, int y, int x, int h, int w, short pair)
+{
+	int row, col, len, wh, ww;
+	getmaxyx(win, wh, ww);
+	nc_win_shadow_iterate(y, x, h, w, row, col, len){
+		if (row < 0 || row >= wh)
+			continue;
+		if (col + len > ww)
+			len = ww - col;
+		if (col < 0){
+			len += col;
+			col = 0;
+		}
+		if (len > 0)
+			mvwchgat(win, row, col, len, A_NORMAL, pair, NULL);
+	}
+}
+
+bool _nc_win_occluded(NcWin *ncwin)
+{
+	// subwindows are drawn in panel of top parent
+	NcWin *top = ncwin;
+	while (top->parent)
+		top = top->parent;
+	if (!top->panel)
+		return false;
+	if (panel_hidden(top->panel))
+		return true;
+
+	int by, bx, h, w, y;
+	getbegyx(ncwin->overlay, by, bx);
+	getmaxyx(ncwin->overlay, h, w);
+	int y0 = by > 0 ? by : 0, y1 = by + h < LINES ? by + h : LINES;
+	int x0 = bx > 0 ? bx : 0, x1 = bx + w < COLS  ? bx + w : COLS;
+	
+	// every row should be covered by chain of panels above
+	for (y = y0; y < y1; ++y) {
+		int x = x0;
+		bool found = true;
+		while (x < x1 && found) {
+			PANEL *p;
+			found = false;
+			for (p = panel_above(top->panel); p; p = panel_above(p)) {
+				int py, px, ph, pw;
+				getbegyx(panel_window(p), py, px);
+				getmaxyx(panel_window(p), ph, pw);
+				if (y >= py && y < py + ph && x >= px && x < px + pw){
+					x = px + pw;
+					found = true;
+				}
+			}
+		}
+		if (x < x1)
+			return false;
+	}
+	return true;
+}
+
+/* cell of lower window under shadow with its own attributes */
+typedef struct NcShadowCell {
+	WINDOW *win;
+	int y, x;
+	attr_t attr;
+} NcShadowCell;
+
+/* shadows are painted to cells of windows under them, cells
+ * of last frame get back their attributes when shadow moves,
+ * is hidden or other window is over it */
+static struct {
+	NcShadowCell *cells; // cells under shadows now
+	NcShadowCell *next;  // cells under shadows in next frame
+	int count, nnext, allocated;
+} shadows;
+
+static void _nc_win_shadow_add(WINDOW *win, int y, int x)
+{
+	if (shadows.nnext == shadows.allocated){
+		int allocated = shadows.allocated ? shadows.allocated * 2 : 256;
+		NcShadowCell *cells = 
+			realloc(shadows.cells, allocated * sizeof(NcShadowCell));
+		if (!cells)
+			return;
+		shadows.cells = cells;
+		NcShadowCell *next = 
+			realloc(shadows.next, allocated * sizeof(NcShadowCell));
+		if (!next)
+			return;
+		shadows.next = next;
+		shadows.allocated = allocated;
+	}
+	NcShadowCell *cell = &shadows.next[shadows.nnext++];
+	cell->win = win;
+	cell->y   = y;
+	cell->x   = x;
+}
+
+/* screen rectangle of panel window */
+typedef struct NcShadowRect {
+	WINDOW *win;
+	int y, x, h, w;
+} NcShadowRect;
+
+/* add cells of shadow row segment of panel k to next frame.
+ * Each cell belongs to top window under panel k, cells under
+ * panels above it have no shadow. Rectangles of panels from
+ * bottom are walked once for the segment */
+static void _nc_win_shadow_row(
+		const NcShadowRect *rects, int n, int k, int row, int col, int len)
+{
+	if (row < 0 || row >= LINES)
+		return;
+	if (col < 0){
+		len += col;
+		col = 0;
+	}
+	if (col + len > COLS)
+		len = COLS - col;
+	if (len <= 0)
+		return;
+
+	WINDOW *owner[len];
+	int i, j;
+	for (i = 0; i < len; ++i)
+		owner[i] = stdscr;
+
+	for (j = 0; j < n; ++j) {
+		const NcShadowRect *r = &rects[j];
+		if (j == k || row < r->y || row >= r->y + r->h)
+			continue;
+		int x0 = r->x > col ? r->x : col;
+		int x1 = r->x + r->w < col + len ? r->x + r->w : col + len;
+		for (i = x0; i < x1; ++i)
+			owner[i - col] = j > k ? NULL : r->win;
+	}
+
+	for (i = 0; i < len; ++i)
+		if (owner[i])
+			_nc_win_shadow_add(owner[i], 
+					row - getbegy(owner[i]), col + i - getbegx(owner[i]));
+}
+
+/* attributes of cell, cursor of window is kept */
+static attr_t _nc_win_cell_attr(const NcShadowCell *cell)
+{
+	int y, x;
+	getyx(cell->win, y, x);
+	chtype ch = mvwinch(cell->win, cell->y, cell->x);
+	wmove(cell->win, y, x);
+	return ch == (chtype)ERR ? A_NORMAL : ch & A_ATTRIBUTES;
+}
+
+static void _nc_win_cell_set(const NcShadowCell *cell, attr_t attr)
+{
+	int y, x;
+	getyx(cell->win, y, x);
+	mvwchgat(cell->win, cell->y, cell->x, 1, 
+			attr & ~A_COLOR, PAIR_NUMBER(attr), NULL);
+	wmove(cell->win, y, x);
+}
+
+/* cell i of next frame is cell i of last frame */
+static bool _nc_win_shadow_kept(int i)
+{
+	if (i >= shadows.count || i >= shadows.nnext)
+		return false;
+	const NcShadowCell *a = &shadows.cells[i], *b = &shadows.next[i];
+	return a->win == b->win && a->y == b->y && a->x == b->x;
+}
+
+void _nc_win_shadows()
+{
+	// rectangles of panels from bottom
+	PANEL *pan;
+	int n = 0, k;
+	for (pan = panel_above(NULL); pan; pan = panel_above(pan))
+		n++;
+	NcShadowRect rects[n > 0 ? n : 1];
+	for (k = 0, pan = panel_above(NULL); pan; pan = panel_above(pan), ++k) {
+		rects[k].win = panel_window(pan);
+		getbegyx(rects[k].win, rects[k].y, rects[k].x);
+		getmaxyx(rects[k].win, rects[k].h, rects[k].w);
+	}
+
+	// shadow cells of next frame
+	shadows.nnext = 0;
+	for (k = 0, pan = panel_above(NULL); pan; pan = panel_above(pan), ++k) {
+		if (panel_userptr(pan) != &nc_win_shadow_mark)
+			continue;
+
+		int row, col, len;
+		nc_win_shadow_iterate(rects[k].y, rects[k].x, rects[k].h, rects[k].w,
+				row, col, len)
+			_nc_win_shadow_row(rects, n, k, row, col, len);
+	}
+
+	// cells out of shadow get back their attributes, cells
+	// repainted by their windows are not restored
+	int i;
+	for (i = 0; i < shadows.count; ++i)
+		if (!_nc_win_shadow_kept(i) &&
+				_nc_win_cell_attr(&shadows.cells[i]) == COLOR_PAIR(BLACK_ON_BLACK))
+			_nc_win_cell_set(&shadows.cells[i], shadows.cells[i].attr);
+
+	// kept cells which still have shadow are not touched
+	for (i = 0; i < shadows.nnext; ++i) {
+		NcShadowCell *cell = &shadows.next[i];
+		attr_t attr = _nc_win_cell_attr(cell);
+		if (attr == COLOR_PAIR(BLACK_ON_BLACK) && _nc_win_shadow_kept(i)){
+			cell->attr = shadows.cells[i].attr;
+			continue;
+		}
+		cell->attr = attr;
+		_nc_win_cell_set(cell, COLOR_PAIR(BLACK_ON_BLACK));
 	}
-	wrefresh(ncwin->overlay);
+
+	NcShadowCell *cells = shadows.cells;
+	shadows.cells = shadows.next;
+	shadows.next  = cells;
+	shadows.count = shadows.nnext;
+}
+
+/* drop cells of deleted window */
+static void _nc_win_shadows_forget(WINDOW *win)
+{
+	int i, n = 0;
+	for (i = 0; i < shadows.count; ++i)
+		if (shadows.cells[i].win != win)
+			shadows.cells[n++] = shadows.cells[i];
+	shadows.count = n;
 }
 
 NcWin *
@@ -58,24 +301,15 @@ nc_win_new(
 		return NULL;
 
 	ncwin->parent = parent;
-	ncwin->shadow = NULL;
+	ncwin->shadow = shadow;
 	ncwin->panel  = NULL;
-	ncwin->spanel = NULL;
 	ncwin->color  = color; 
 	ncwin->title  = NULL;
 	ncwin->box    = makebox;
+	ncwin->stats_frame = 0;
+	ncwin->stats_cells = 0;
+	memset(&ncwin->stats, 0, sizeof(NcStats));
 	
-	if (shadow){
-		if (parent){
-			ncwin->shadow = derwin(parent->panel->win, h, w, y + 1, x + 2);	
-		} else {
-			ncwin->shadow = newwin(h, w, y + 1, x + 2);	
-			ncwin->spanel = new_panel(ncwin->shadow);
-		}
-		wbkgd(ncwin->shadow, COLOR_PAIR(BLACK_ON_BLACK));
-		wrefresh(ncwin->shadow);
-	}
-
 	if (parent)
 		ncwin->overlay = derwin(parent->panel->win, h, w, y, x);
 	else
@@ -86,6 +320,10 @@ nc_win_new(
 	}
 	wbkgd(ncwin->overlay, COLOR_PAIR(color));
 
+	// shadow of subwindow is part of parent window
+	if (shadow && parent)
+		_nc_win_paint_shadow(parent->panel->win, y, x, h, w, BLACK_ON_BLACK);
+
 	if (ncwin->box)
 		box(ncwin->overlay, 0, 0);
 	
@@ -93,11 +331,13 @@ nc_win_new(
 		nc_win_set_title(ncwin, title);
 	}
 
-	if (!parent)
+	if (!parent){
 		ncwin->panel = new_panel(ncwin->overlay);
+		if (shadow)
+			set_panel_userptr(ncwin->panel, &nc_win_shadow_mark);
+	}
 
-	update_panels();
-	doupdate();
+	_nc_frame_stage(ncwin);
 
 	return ncwin;
 }
@@ -107,13 +347,9 @@ int nc_win_move(NcWin *ncwin, int y, int x){
 	if (ncwin->parent)
 		return -1;
 	
-	if (ncwin->spanel)
-		ret = move_panel(ncwin->spanel, y + 1, x + 2);
-	
 	ret = move_panel(ncwin->panel, y, x);
 	
-	update_panels();
-	doupdate();
+	_nc_frame_stage(ncwin);
 
 	return ret;
 }
@@ -123,16 +359,12 @@ int nc_win_resize(NcWin *ncwin, int h, int w){
 	if (ncwin->parent)
 		return -1;
 	
-	wresize(ncwin->overlay, h, w);
-	
-	if (ncwin->shadow)
-		wresize(ncwin->shadow, h, w);
+	ret = wresize(ncwin->overlay, h, w);
 	
 	if (ncwin->box)
 		box(ncwin->overlay, 0, 0);
 
-	update_panels();
-	doupdate();
+	_nc_frame_stage(ncwin);
 
 	return ret;
 }
@@ -142,11 +374,8 @@ int nc_win_hide(NcWin *ncwin)
 	if (ncwin->parent)
 		return -1;
 
-	if (ncwin->spanel)
-		hide_panel(ncwin->spanel);
 	int ret = hide_panel(ncwin->panel);
-	update_panels();
-	doupdate();
+	_nc_frame_stage(ncwin);
 	return ret;
 }
 
@@ -155,11 +384,8 @@ int nc_win_show(NcWin *ncwin)
 	if (ncwin->parent)
 		return -1;
 	
-	if (ncwin->spanel)
-		show_panel(ncwin->spanel);
 	int ret =  show_panel(ncwin->panel);
-	update_panels();
-	doupdate();
+	_nc_frame_stage(ncwin);
 	return ret;
 }
 
@@ -180,11 +406,8 @@ nc_win_activate(NcWin *ncwin)
 	if (nc_win_hidden(ncwin))
 		nc_win_show(ncwin);
 
-	if (ncwin->shadow)
-		top_panel(ncwin->spanel);
 	int ret = top_panel(ncwin->panel);
-	update_panels();
-	doupdate();
+	_nc_frame_stage(ncwin);
 	return ret;	
 }
 
@@ -192,16 +415,17 @@ void nc_win_destroy(NcWin *ncwin)
 {
 	NcWin *parent = ncwin->parent;
 	werase(ncwin->overlay);
-	if (ncwin->shadow)
-		werase(ncwin->shadow);
-	if (ncwin->panel)
+	if (ncwin->shadow && parent){
+		int y, x, h, w;
+		getparyx(ncwin->overlay, y, x);
+		getmaxyx(ncwin->overlay, h, w);
+		_nc_win_paint_shadow(parent->panel->win, y, x, h, w, parent->color);
+	}
+	if (ncwin->panel){
 		del_panel(ncwin->panel);
-	if (ncwin->spanel)
-		del_panel(ncwin->spanel);
+		_nc_win_shadows_forget(ncwin->overlay);
+	}
 	if (ncwin->title)
-		free(ncwin->title);
-	if (parent)
-		wrefresh(parent->panel->win);
-	update_panels();
-	doupdate();	
+		nc_text_free(ncwin->title);
+	_nc_frame_stage(ncwin);
 }
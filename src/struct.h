@@ -2,24 +2,130 @@
  * File              : struct.h
  * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
  * Date              : 08.05.2024
- * Last Modified Date: 08.05.2024
+ * Last Modified Date: 17.10.2026
  * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
  */
 #ifndef NCWIDGETS_STRUCTURES_H
 #define NCWIDGETS_STRUCTURES_H
 
 #include "ncwidgets.h"
+#include <pthread.h>
 
 /* structs */
+typedef struct NcSpan {
+	uint32_t offset; // byte offset of first char with attr
+	attr_t attr;
+} NcSpan;
+
+/* byte offset and column of every NC_TEXT_STEP'th char */
+#define NC_TEXT_STEP 64
+typedef struct NcTextIndex {
+	uint32_t count;
+	struct {
+		uint32_t pos, col;
+	} marks[];
+} NcTextIndex;
+
+struct NcText {
+	uint32_t len;       // bytes of text
+	uint32_t chars;     // chars of text
+	uint32_t cols;      // terminal columns of text
+	uint32_t allocated; // bytes allocated after spans
+	NcTextIndex *index; // built on first lookup of not ascii text
+	uint32_t refs;      // users of interned text, 0 - not interned
+	uint32_t hash;      // hash of interned text
+	struct NcText *next;// next interned text with the same bucket
+	uint32_t nspans;
+	NcSpan spans[];     // followed by bytes
+};
+
+/* text keeps utf8 bytes without markup in one block after
+ * array of spans - attributes change only at span offsets */
+#define _nc_text_bytes(text) ((char *)&(text)->spans[(text)->nspans])
+
+/* drop reference to interned text */
+void _nc_text_release(NcText *text);
+
+/* text of list or label row - interned if enabled */
+NcText *_nc_text_row(const char *markup, int color);
+
+/* decoded row of owner from cache or NULL */
+NcText *_nc_cache_get(const void *owner, int index);
+/* move decoded row to cache - return -1 on error (text is
+ * not taken) */
+int _nc_cache_put(const void *owner, int index, NcText *text);
+/* free cached rows of owner */
+void _nc_cache_drop(const void *owner);
+/* start new frame - rows of last frame can be dropped */
+void _nc_cache_frame();
+
+/* piece of compiled template - literal text with one 
+ * attribute or placeholder of value */
+typedef struct NcPiece {
+	int slot;           // index of value, -1 for literal
+	attr_t attr;
+	uint32_t offset;    // literal bytes in template
+	uint32_t len;
+	uint32_t chars;
+	uint32_t cols;
+} NcPiece;
+
+struct NcTemplate {
+	int npieces;
+	int slots;
+	NcPiece *pieces;
+	char *bytes;
+};
+
+/* max length of markup tag kept by decoder */
+#define NC_DECODER_TAG 32
+/* max number of params of ANSI escape sequence */
+#define NC_DECODER_PARAMS 32
+
+struct NcDecoder {
+	int color;
+	attr_t attr;
+	void (*on_line)(void *userdata, NcText *line);
+	void *userdata;
+
+	// unfinished markup tag, escape sequence and utf8 char
+	// of last chunk
+	enum {
+		NcDecoderText, NcDecoderLess, NcDecoderTag,
+		NcDecoderEsc, NcDecoderCsi, NcDecoderOsc, NcDecoderOscEsc
+	} state;
+	char tag[NC_DECODER_TAG + 4];
+	int ntag;
+
+	// ANSI escape sequences instead of markup
+	bool ansi;
+	int params[NC_DECODER_PARAMS];
+	int nparams;
+	bool marker;        // private sequence - not SGR
+	short fg, bg;       // color index of pair, -1 - default
+	char part[5];
+	int npart, need;
+
+	// decoded chars of current line
+	char *bytes;
+	uint32_t len, allocated;
+	NcSpan *spans;
+	uint32_t nspans, aspans;
+	uint32_t chars, cols;
+	NcText *pending;
+};
+
 struct NcWin {
 	struct NcWin *parent;
-	PANEL *spanel;
 	PANEL *panel;
 	WINDOW *overlay;
-	WINDOW *shadow;
+	bool shadow;
 	int color;
-	u8char_t *title;
+	NcText *title;
 	bool box;
+	NcStats stats;
+	unsigned long stats_frame; // frame with not counted cells 
+	unsigned long stats_cells;
 };
 
 struct NcWidget {
@@ -36,6 +142,7 @@ struct NcWidget {
 	void (*on_destroy)(NcWidget *widget);
 	int key;
 	void *userdata;
+	bool invalid;
 };
 
 enum nccalendar_selected{
@@ -53,8 +160,7 @@ struct NcCalendar {
 
 struct NcEntry {
 	NcWidget ncwidget;
-	u8char_t *info;
-	size_t allocated;
+	NcText *info;
 	bool multiline;
 	size_t position;
 	int ypos;	
@@ -63,20 +169,192 @@ struct NcEntry {
 
 struct NcLabel {
 	NcWidget ncwidget;
-	u8char_t **info;
+	NcText **info;
 	int lines;
 };
 
+/* rows of async list are fetched by pages on worker thread */
+#define NC_LIST_PAGE     64  // rows in page
+#define NC_LIST_PAGES    8   // pages in cache
+#define NC_LIST_PREFETCH 2   // pages fetched ahead of scroll
+
+typedef struct NcListPage {
+	int first;          // index of first row, -1 - empty slot
+	enum {NcPageQueued, NcPageLoading, NcPageReady} state;
+	bool urgent;        // page has visible rows
+	unsigned long used; // time of last use to drop old pages
+	NcText *rows[NC_LIST_PAGE];
+} NcListPage;
+
+typedef struct NcListAsync {
+	NcList *nclist;
+	NcListFill fill;
+	void *userdata;
+	int size;
+	NcText *placeholder;
+
+	// pages are shared with worker
+	NcListPage pages[NC_LIST_PAGES];
+	unsigned long clock;
+	bool arrived;       // page is ready - list should repaint
+	bool stop;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+
+	int direction;      // last scroll direction, 1 or -1
+	int last_ypos;
+	struct NcListAsync *next;
+} NcListAsync;
+
+/* filter of list rows - plain text of rows without case is
+ * kept in one buffer with trigram index of it. Size of list
+ * is number of matched rows while filter is set */
+#define NC_FILTER_SEGMENT 16384 // rows of index segment
+#define NC_FILTER_BUCKETS 65536
+
+typedef struct NcFilterSegment {
+	// rows with trigram hash k are postings[index[k]..index[k+1]]
+	uint32_t index[NC_FILTER_BUCKETS + 1];
+	int postings[];
+} NcFilterSegment;
+
+/* ranked row of fuzzy filter */
+typedef struct NcFuzzyHit {
+	int score;
+	int len;            // shorter row is better with equal score
+	int row;
+} NcFuzzyHit;
+
+/* bytes allocated after folded text of filter rows, vector
+ * loads of row end may read them */
+#define NC_FILTER_PAD 32
+
+typedef struct NcListFilter {
+	int size;           // rows of source
+	char *bytes;        // folded text of rows, NC_FILTER_PAD more
+	size_t nbytes, allocated;
+	uint32_t *offsets;  // row i is bytes offsets[i]..offsets[i+1]
+	uint64_t *masks;    // chars of row, see _nc_filter_mask()
+	int allocated_offsets;
+
+	// every full segment of rows has own index, rows after
+	// them are searched without index
+	NcFilterSegment **segments;
+	int nsegments;
+
+	char *query;        // folded query
+	size_t querylen;
+	int *match;         // source rows of matched rows, ascending
+	int nmatch;
+	int *spare;         // second match buffer of fuzzy filter
+	int allocated_match;
+
+	// best rows of fuzzy filter - shown rows of list
+	NcFuzzyHit *rank;
+	int nrank;
+	uint32_t *pos;      // positions of query chars in row
+} NcListFilter;
+
 struct NcList {
 	NcWidget ncwidget;
-	u8char_t **info;
+	NcText **info;
 	int size;
+	int allocated;
 	int selected;
 	int ypos;	
 	int xpos;	
 	void (*on_set_value)(NcList *nclist, char **value, int size);
+
+	// borrowed strings of caller or rows of fill callback
+	// are decoded when visible and kept in row cache
+	const char **borrowed;
+	NcListFill fill;
+	void *userdata;
+	NcListAsync *async;
+	NcListFilter *filter;
+	bool filtering;     // printable keys change filter
+	int fuzzy;          // rows shown by fuzzy filter, 0 - off
+	attr_t fuzzy_attr;  // attribute of matched chars
+	
+	// rows to repaint and state of last paint
+	bool *dirty;
+	int rows, cols;
+	int drawn_selected;
+	int drawn_ypos;	
+	int drawn_xpos;	
+	bool drawn_focused;
 };
 
+/* mark list row with index to repaint */
+void _nc_list_mark_row(NcList *nclist, int index);
+
+/* mark all visible rows of list to repaint */
+void _nc_list_mark_all(NcList *nclist);
+
+/* text of list row, NULL for row out of list. Row which
+ * could not be cached is owned by caller and freed after use */
+NcText *_nc_list_row(NcList *nclist, int index, bool *owned);
+
+/* free rows of list */
+void _nc_list_clear(NcList *nclist);
+
+/* add source row appended to list to filter, return -1 on
+ * error */
+int _nc_list_filter_add(NcList *nclist, int index);
+
+/* free filter of list - list shows all rows */
+void _nc_list_filter_free(NcList *nclist);
+
+/* bit of every char class in str */
+uint64_t _nc_filter_mask(const char *str, size_t len);
+
+/* decoded row of list source, not filtered, owned as
+ * _nc_list_row() */
+NcText *_nc_list_source_row(NcList *nclist, int index, bool *owned);
+
+/* rank rows of filter by fuzzy query, query is taken by
+ * filter. Return -1 on error */
+int _nc_list_fuzzy(NcList *nclist, char *query, size_t len);
+
+/* add appended source row to ranked rows */
+int _nc_list_fuzzy_add(NcList *nclist, int index);
+
+/* shown row of fuzzy filter with marked chars of query,
+ * owned as _nc_list_row() */
+NcText *_nc_list_fuzzy_row(NcList *nclist, int index, bool *owned);
+
+/* stop workers of fuzzy filter */
+void _nc_fuzzy_quit();
+
+/* copy of text with attr added to chars at byte positions,
+ * positions are ascending */
+NcText *_nc_text_mark(
+		const NcText *text, const uint32_t *pos, size_t npos, attr_t attr);
+
+/* row of async list or placeholder, rows are requested */
+NcText *_nc_list_async_row(NcList *nclist, int index);
+
+/* stop worker and free rows of async list */
+void _nc_list_async_free(NcList *nclist);
+
+/* repaint async lists with arrived rows, return true if 
+ * some rows are still fetched */
+bool _nc_list_async_poll();
+
+/* create list widget allocated with size */
+NcWidget * _nc_list_new(
+		NcWin *parent,
+		const char *title,
+		int h, int w, int y, int x,
+		int color,
+		char **value,
+		int size,
+		bool box,
+		bool shadow,
+		size_t allocated
+		);
+
 void nc_list_activate(
 		NcWidget *ncwidget,
 		void *userdata,
@@ -118,4 +396,52 @@ struct NcGroup{
 	NcWidget *object;
 };
 
+/* stage window output to next frame */
+void _nc_frame_stage(NcWin *ncwin);
+
+/* paint shadows of top level windows to cells of windows
+ * under them, called before update_panels() */
+void _nc_win_shadows();
+
+/* true if no cell of window is visible - window panel is
+ * hidden or window is covered by panels above */
+bool _nc_win_occluded(NcWin *ncwin);
+
+/* open output stream of curses to count output written to 
+ * target file descriptor */
+FILE *_nc_stats_open(int target);
+void _nc_stats_close(FILE *fp);
+
+/* count cells staged by window */
+void _nc_stats_stage(NcWin *ncwin);
+
+/* count output of flushed frame */
+void _nc_stats_flush();
+
+/* paint one row of window in single pass: chars of str 
+ * (len chars or whole string if len < 0) which fit to width 
+ * columns with attr added, then blanks with fill attributes
+ * to the end of row. Char with index cursor is reversed. 
+ * Return number of painted chars */
+int _nc_paint_row(
+		WINDOW *win, int y, int x, int width,
+		const u8char_t *str, int len,
+		attr_t attr, attr_t fill, int cursor);
+
+/* paint row like _nc_paint_row() from text iterator, runs
+ * of chars with the same attributes are written straight
+ * from text bytes. Iterator is moved after painted chars.
+ * Only blanks are painted if it is NULL */
+int _nc_paint_text(
+		WINDOW *win, int y, int x, int width,
+		NcTextIter *it, int len,
+		attr_t attr, attr_t fill, int cursor);
+
+/* put chars of utf8 string to cells starting from pos, but
+ * not after max. Return position after last char, -1 if attr
+ * can not be interned */
+int _nc_cells_put(
+		u8char_t *cells, int pos, int max,
+		const char *str, attr_t attr);
+
 #endif /* ifndef NCWIDGETS_STRUCTURES_H */
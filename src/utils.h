@@ -2,7 +2,7 @@
  * File              : utils.h
  * Author            : Igor V. Sementsov <ig.kuzm@gmail.com>
  * Date              : 12.06.2023
- * Last Modified Date: 09.05.2024
+ * Last Modified Date: 17.10.2026
  * Last Modified By  : Igor V. Sementsov <ig.kuzm@gmail.com>
  */
 
@@ -11,10 +11,17 @@
 
 #include <curses.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 static void
 _buf2attr(attr_t *attr, char *str, int add, int defcolor)
 {
@@ -60,6 +67,33 @@ _buf2attr(attr_t *attr, char *str, int add, int defcolor)
 	}
 }
 
+/* true if str starts markup tag </...> or <!...> */
+static int
+_nc_markup_is_tag(const char *str)
+{
+	return str[0] == '<' && (str[1] == '/' || str[1] == '!');
+}
+
+/* apply markup tag at start of str to attr, return number
+ * of bytes of tag */
+static size_t
+_nc_markup_tag(const char *str, attr_t *attr, int color)
+{
+	char buf[32];
+	int add = str[1] == '/';
+	size_t buflen = 0, i = 2;
+	while (str[i] && str[i] != '>') {
+		if (buflen < sizeof(buf) - 1)
+			buf[buflen++] = str[i];
+		i++;
+	}
+	buf[buflen] = 0;
+	if (str[i])
+		i++;
+	_buf2attr(attr, buf, add, color);
+	return i;
+}
+
 /*static chtype  **/
 /*str2chtypestr(const char *str, int color)*/
 /*{*/
@@ -97,39 +131,219 @@ _buf2attr(attr_t *attr, char *str, int add, int defcolor)
 	/*return chtypestr;*/
 /*}*/
 
-typedef struct {
-	char utf8[7];
-	attr_t attr;
-} u8char_t;
+/* packed char: 21 bits of unicode codepoint and 11 bits of
+ * index in table of interned attributes - 4 bytes per char.
+ * Char with zero codepoint ends string. Table is shared by
+ * all widgets and keeps U8CHAR_ATTRS different attributes
+ * (colour pair with flags), chars with other attributes can
+ * not be packed after it is full */
+typedef uint32_t u8char_t;
+
+#define U8CHAR_CP_BITS 21
+#define U8CHAR_CP_MASK 0x1FFFFF
+#define U8CHAR_ATTRS   2048
+#define U8CHAR_INVALID 0xFFFD
+
+/* table of interned attributes, index 0 is A_NORMAL */
+extern attr_t _nc_attrs[U8CHAR_ATTRS];
+
+/* return index of attr in table of interned attributes,
+ * -1 if table is full */
+int _nc_attr_intern(attr_t attr);
+
+#define u8char_cp(c)    ((c) & U8CHAR_CP_MASK)
+#define u8char_index(c) ((c) >> U8CHAR_CP_BITS)
+#define u8char_attr(c)  (_nc_attrs[u8char_index(c)])
+#define u8char_pack(cp, index) \
+	((u8char_t)(cp) | ((u8char_t)(index) << U8CHAR_CP_BITS))
+
+/* decode utf8 char to codepoint, return number of bytes
+ * of char. Invalid and truncated sequences, overlongs and
+ * surrogates are decoded as U+FFFD - decoder never reads 
+ * after zero byte */
+static int
+utf8_decode(const char *str, uint32_t *cp)
+{
+	const unsigned char *s = (const unsigned char *)str;
+	unsigned char c = s[0];
+	uint32_t min;
+	int i, len;
+	if (c < 0x80){
+		*cp = c;
+		return 1;
+	}
+	if      (c >= 0xF0 && c <= 0xF4) /* 4-bytes */
+		len = 4, min = 0x10000, *cp = c & 0x07;
+	else if (c >= 0xE0 && c <= 0xEF) /* 3-bytes */
+		len = 3, min = 0x800,   *cp = c & 0x0F;
+	else if (c >= 0xC2 && c <= 0xDF) /* 2-bytes */
+		len = 2, min = 0x80,    *cp = c & 0x1F;
+	else {
+		*cp = U8CHAR_INVALID;
+		return 1;
+	}
+	for (i = 1; i < len; ++i) {
+		if ((s[i] & 0xC0) != 0x80){
+			*cp = U8CHAR_INVALID;
+			return i;
+		}
+		*cp = (*cp << 6) | (s[i] & 0x3F);
+	}
+	if (*cp < min || *cp > 0x10FFFF || (*cp >= 0xD800 && *cp <= 0xDFFF))
+		*cp = U8CHAR_INVALID;
+	return len;
+}
+
+/* return number of leading ascii bytes of str (not more
+ * than len) which are not equal to stop - 32 or 16 bytes
+ * are checked in one step with AVX2 or SSE2 */
+static size_t
+utf8_ascii_run(const char *str, size_t len, char stop)
+{
+	size_t i = 0;
+#if defined(__AVX2__)
+	__m256i vstop32 = _mm256_set1_epi8(stop);
+	for (; i + 32 <= len; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)&str[i]);
+		// high bit is set for non ascii bytes and stop chars
+		unsigned int mask = _mm256_movemask_epi8(
+				_mm256_or_si256(v, _mm256_cmpeq_epi8(v, vstop32)));
+		if (mask)
+			return i + __builtin_ctz(mask);
+	}
+#endif
+#if defined(__SSE2__)
+	__m128i vstop = _mm_set1_epi8(stop);
+	for (; i + 16 <= len; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)&str[i]);
+		unsigned int mask = _mm_movemask_epi8(
+				_mm_or_si128(v, _mm_cmpeq_epi8(v, vstop)));
+		if (mask)
+			return i + __builtin_ctz(mask);
+	}
+#endif
+	for (; i < len; ++i)
+		if ((unsigned char)str[i] >= 0x80 || str[i] == stop)
+			break;
+	return i;
+}
+
+/* convert leading ascii bytes of str which are not stop to
+ * chars with attribute index. Return number of converted
+ * chars */
+static size_t
+utf8_ascii_widen(
+		const char *str, size_t len, char stop, 
+		u8char_t *cells, int index)
+{
+	size_t i = 0, n;
+	u8char_t high = u8char_pack(0, index);
+#if defined(__SSE2__)
+	__m128i vstop = _mm_set1_epi8(stop);
+	__m128i vhigh = _mm_set1_epi32(high);
+	__m128i zero  = _mm_setzero_si128();
+	for (; i + 16 <= len; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)&str[i]);
+		if (_mm_movemask_epi8(_mm_or_si128(v, _mm_cmpeq_epi8(v, vstop))))
+			break;
+		// bytes -> 16 bit -> 32 bit with attribute index
+		__m128i lo = _mm_unpacklo_epi8(v, zero);
+		__m128i hi = _mm_unpackhi_epi8(v, zero);
+		__m128i *out = (__m128i *)&cells[i];
+		_mm_storeu_si128(out,     
+				_mm_or_si128(_mm_unpacklo_epi16(lo, zero), vhigh));
+		_mm_storeu_si128(out + 1, 
+				_mm_or_si128(_mm_unpackhi_epi16(lo, zero), vhigh));
+		_mm_storeu_si128(out + 2, 
+				_mm_or_si128(_mm_unpacklo_epi16(hi, zero), vhigh));
+		_mm_storeu_si128(out + 3, 
+				_mm_or_si128(_mm_unpackhi_epi16(hi, zero), vhigh));
+	}
+#endif
+	n = i + utf8_ascii_run(&str[i], len - i, stop);
+	for (; i < n; ++i)
+		cells[i] = (unsigned char)str[i] | high;
+	return n;
+}
+
+/* return number of chars in first len bytes of str and set
+ * bytes to offset after count chars if count >= 0 */
+static size_t
+utf8_count(const char *str, size_t len, long count, size_t *bytes)
+{
+	size_t i = 0, n = 0;
+	uint32_t cp;
+	while (i < len && (count < 0 || n < (size_t)count)) {
+		size_t run = utf8_ascii_run(&str[i], len - i, 0);
+		if (count >= 0 && run > (size_t)count - n)
+			run = (size_t)count - n;
+		i += run;
+		n += run;
+		if (i < len && (count < 0 || n < (size_t)count)){
+			i += utf8_decode(&str[i], &cp);
+			n++;
+		}
+	}
+	if (bytes)
+		*bytes = i < len ? i : len;
+	return n;
+}
+
+/* number of terminal columns of char. Chars before
+ * combining marks are one column - control chars are
+ * painted as blanks */
+static inline int
+utf8_width(uint32_t cp)
+{
+	if (cp < 0x300)
+		return 1;
+	int w = wcwidth(cp);
+	return w < 0 ? 1 : w;
+}
+
+/* encode codepoint to utf8, return number of bytes */
+static int
+utf8_encode(uint32_t cp, char *buf)
+{
+	if (cp < 0x80){
+		buf[0] = cp;
+		return 1;
+	}
+	if (cp < 0x800){
+		buf[0] = 0xC0 | (cp >> 6);
+		buf[1] = 0x80 | (cp & 0x3F);
+		return 2;
+	}
+	if (cp < 0x10000){
+		buf[0] = 0xE0 | (cp >> 12);
+		buf[1] = 0x80 | ((cp >> 6) & 0x3F);
+		buf[2] = 0x80 | (cp & 0x3F);
+		return 3;
+	}
+	buf[0] = 0xF0 | (cp >> 18);
+	buf[1] = 0x80 | ((cp >> 12) & 0x3F);
+	buf[2] = 0x80 | ((cp >> 6) & 0x3F);
+	buf[3] = 0x80 | (cp & 0x3F);
+	return 4;
+}
 
 static char *
 ucharstr2str(const u8char_t *ucharstr)
 {
-	int size = BUFSIZ;
-	char *str = malloc(size);
+	// count exact size
+	size_t i, l = 0;
+	for (i = 0; u8char_cp(ucharstr[i]); ++i) {
+		uint32_t cp = u8char_cp(ucharstr[i]);
+		l += cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+	}
+
+	char *str = malloc(l + 1);
 	if (!str)
 		return NULL;
 
-	size_t i = 0, l = 0;
-	while (ucharstr[i].utf8[0]){
-		const char *s = ucharstr[i++].utf8;
-		int len = strlen(s);
-
-		//realloc size
-		if (size < l + len){
-			size += BUFSIZ;
-			void *ptr = realloc(str, size);
-			if (!ptr)
-				return NULL;
-			str = ptr;
-		}
-
-		//set string
-		int k;
-		for (k = 0; k < len; ++k) {
-			str[l++] = s[k];
-		}
-	}
+	//set string
+	for (i = 0, l = 0; u8char_cp(ucharstr[i]); ++i)
+		l += utf8_encode(u8char_cp(ucharstr[i]), &str[l]);
 
 	//terminate string
 	str[l] = 0;
@@ -137,145 +351,77 @@ ucharstr2str(const u8char_t *ucharstr)
 	return str;
 }
 
+/* chars of str with markup tags applied, NULL if there is no
+ * memory or attributes can not be interned */
 static u8char_t *
 str2ucharstr(const char *str, int color)
 {
 	size_t len = strlen(str);
-	u8char_t *ucharstr = malloc(len * sizeof(u8char_t) + 1);
+	u8char_t *ucharstr = malloc((len + 1) * sizeof(u8char_t));
 	if (!ucharstr)
 		return NULL;
 
-	size_t i, l = 0, k; 
+	size_t i = 0, l = 0; 
 	attr_t attr = A_NORMAL|COLOR_PAIR(color);
-	char buf[32];
-	int buflen = 0;
-	for (i = 0; i < len; ++i) {
-		if (str[i] == '<'){
-			if (str[i+1] == '/' || str[i+1] == '!'){
-				// start of attributes
-				int add = 1;
-				if (str[i+1] == '!')
-					add = 0;
-				i+=2;
-				while (str[i] != '>') {
-					buf[buflen++] = str[i++];
-				}
-				buf[buflen++] = 0;
-				_buf2attr(&attr, buf, add, color);
-				i++;
-				buflen = 0;
-			}
+	int index = _nc_attr_intern(attr);
+	while (i < len && index >= 0) {
+		if (_nc_markup_is_tag(&str[i])){
+			// start of attributes
+			i += _nc_markup_tag(&str[i], &attr, color);
+			index = _nc_attr_intern(attr);
+			continue;
 		}
 
-		unsigned char c = str[i];
-		if (c >= 252){/* 6-bytes */
-			ucharstr[l].utf8[0] = str[i++]; 
-			ucharstr[l].utf8[1] = str[i++]; 
-			ucharstr[l].utf8[2] = str[i++]; 
-			ucharstr[l].utf8[3] = str[i++]; 
-			ucharstr[l].utf8[4] = str[i++]; 
-			ucharstr[l].utf8[5] = str[i]; 
-			ucharstr[l].utf8[6] = 0; 
-		} 
-		else if (c >= 248){/* 5-bytes */
-			ucharstr[l].utf8[0] = str[i++]; 
-			ucharstr[l].utf8[1] = str[i++]; 
-			ucharstr[l].utf8[2] = str[i++]; 
-			ucharstr[l].utf8[3] = str[i++]; 
-			ucharstr[l].utf8[4] = str[i]; 
-			ucharstr[l].utf8[5] = 0; 
-		}
-		else if (c >= 240){/* 4-bytes */
-			ucharstr[l].utf8[0] = str[i++]; 
-			ucharstr[l].utf8[1] = str[i++]; 
-			ucharstr[l].utf8[2] = str[i++]; 
-			ucharstr[l].utf8[3] = str[i]; 
-			ucharstr[l].utf8[4] = 0; 
-		} 
-		else if (c >= 224){/* 3-bytes */
-			ucharstr[l].utf8[0] = str[i++]; 
-			ucharstr[l].utf8[1] = str[i++]; 
-			ucharstr[l].utf8[2] = str[i]; 
-			ucharstr[l].utf8[3] = 0; 
+		// ascii run up to next tag
+		if ((unsigned char)str[i] < 0x80 && str[i] != '<'){
+			size_t n = utf8_ascii_widen(&str[i], len - i, '<', 
+					&ucharstr[l], index);
+			i += n;
+			l += n;
+			continue;
 		}
-		else if (c >= 192){/* 2-bytes */
-			ucharstr[l].utf8[0] = str[i++]; 
-			ucharstr[l].utf8[1] = str[i]; 
-			ucharstr[l].utf8[2] = 0; 
-		} 
-		else{/* 1-byte */
-			ucharstr[l].utf8[0] = str[i]; 
-			ucharstr[l].utf8[1] = 0; 
-		} 
-		
-		ucharstr[l++].attr = attr;
+
+		uint32_t cp;
+		i += utf8_decode(&str[i], &cp);
+		ucharstr[l++] = u8char_pack(cp, index);
 	}
-	ucharstr[l++].utf8[0] = 0;
+
+	// attributes can not be packed
+	if (index < 0){
+		free(ucharstr);
+		return NULL;
+	}
+	ucharstr[l++] = 0;
 	return ucharstr;
 }
 
 static char *
 move_char_right(char *str)
 {
-	int i = 0;
-	unsigned char c = str[i];
-	if      (c >= 252) /* 6-bytes */
-		i+=6;
-	else if (c >= 248) /* 5-bytes */
-		i+=5;
-	else if (c >= 240) /* 4-bytes */
-		i+=4;
-	else if (c >= 224) /* 3-bytes */
-		i+=3;
-	else if (c >= 192) /* 2-bytes */
-		i+=2;
-	else               /* 1-byte  */
-		i++;
-		
-	return &str[i];
+	uint32_t cp;
+	return &str[utf8_decode(str, &cp)];
 }
 
 /* return char index of utf8 string n'th miltibite char */
 static int
 uchar_index(char *str, int n)
 {
-	int i = 0, k;
-	for (k = 0; k < n; ++k) {
-		unsigned char c = str[i];
-		if      (c >= 252) /* 6-bytes */
-			i+=6;
-		else if (c >= 248) /* 5-bytes */
-			i+=5;
-		else if (c >= 240) /* 4-bytes */
-			i+=4;
-		else if (c >= 224) /* 3-bytes */
-			i+=3;
-		else if (c >= 192) /* 2-bytes */
-			i+=2;
-		else               /* 1-byte  */
-			i++;
-	}
+	size_t i;
+	utf8_count(str, strlen(str), n, &i);
 	return i;
 }
 
 static int
 strchars(const char *str)
 {
-	char * ptr = (char *)str;
-	int c = 0;
-	while (*ptr){
-		ptr = move_char_right(ptr);
-		c++;
-	}
-	
-	return c;	
+	return utf8_count(str, strlen(str), -1, NULL);
 }
 
 static size_t
 ucharstrlen(u8char_t *str)
 {
 	size_t i = 0;
-	while (str[i].utf8[0])
+	while (u8char_cp(str[i]))
 		i++;
 	
 	return i;	